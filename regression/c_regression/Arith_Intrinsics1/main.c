@@ -0,0 +1,100 @@
+#include <assert.h>
+#include <limits.h>
+
+int nondet_int();
+
+/* InstCombine turns these selects into smax, smin, umax and umin. */
+int smax(int a, int b)
+{
+  return a > b ? a : b;
+}
+
+int smin(int a, int b)
+{
+  return a < b ? a : b;
+}
+
+unsigned umax(unsigned a, unsigned b)
+{
+  return a > b ? a : b;
+}
+
+unsigned umin(unsigned a, unsigned b)
+{
+  return a < b ? a : b;
+}
+
+/* llvm.abs with the is-int-min-poison flag clear. */
+int iabs(int a)
+{
+  return a < 0 ? -(unsigned)a : a;
+}
+
+/* Saturating forms that InstCombine folds into the sat intrinsics. */
+int sadd_sat(int a, int b)
+{
+  int r;
+  if (__builtin_add_overflow(a, b, &r))
+    return a < 0 ? INT_MIN : INT_MAX;
+  return r;
+}
+
+int ssub_sat(int a, int b)
+{
+  int r;
+  if (__builtin_sub_overflow(a, b, &r))
+    return a < 0 ? INT_MIN : INT_MAX;
+  return r;
+}
+
+unsigned uadd_sat(unsigned a, unsigned b)
+{
+  unsigned r = a + b;
+  return r < a ? UINT_MAX : r;
+}
+
+unsigned usub_sat(unsigned a, unsigned b)
+{
+  return a > b ? a - b : 0;
+}
+
+int main()
+{
+  assert(smax(-5, 3) == 3);
+  assert(smin(-5, 3) == -5);
+  assert(smax(INT_MIN, INT_MAX) == INT_MAX);
+  assert(smin(INT_MIN, INT_MAX) == INT_MIN);
+
+  /* Above INT_MAX, so the signed and unsigned orders differ. */
+  assert(umax(0x80000000u, 1) == 0x80000000u);
+  assert(umin(0x80000000u, 1) == 1);
+  assert(umax(0xffffffffu, 0x7fffffffu) == 0xffffffffu);
+  assert(umin(0xffffffffu, 0x7fffffffu) == 0x7fffffffu);
+
+  assert(iabs(-7) == 7);
+  assert(iabs(7) == 7);
+  assert(iabs(0) == 0);
+  assert(iabs(INT_MIN) == INT_MIN);
+
+  assert(sadd_sat(1, 2) == 3);
+  assert(sadd_sat(INT_MAX, 1) == INT_MAX);
+  assert(sadd_sat(INT_MIN, -1) == INT_MIN);
+  assert(ssub_sat(1, 2) == -1);
+  assert(ssub_sat(INT_MIN, 1) == INT_MIN);
+  assert(ssub_sat(INT_MAX, -1) == INT_MAX);
+
+  assert(uadd_sat(1, 2) == 3);
+  assert(uadd_sat(0xfffffff0u, 0x20) == UINT_MAX);
+  assert(uadd_sat(0x80000000u, 0x80000000u) == UINT_MAX);
+  assert(usub_sat(5, 3) == 2);
+  assert(usub_sat(3, 5) == 0);
+  assert(usub_sat(0x80000000u, 1) == 0x7fffffffu);
+
+  int x = nondet_int();
+  int y = nondet_int();
+  assert(smax(x, y) >= x && smax(x, y) >= y);
+  assert(smin(x, y) <= x && smin(x, y) <= y);
+  assert(umax(x, y) >= (unsigned)x && umin(x, y) <= (unsigned)y);
+  assert(x == INT_MIN || iabs(x) >= 0);
+  return 0;
+}
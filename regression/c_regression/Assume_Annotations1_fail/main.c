@@ -0,0 +1,18 @@
+#include <assert.h>
+#include <limits.h>
+
+int nondet_int();
+
+/* p is noundef nonnull, and the add carries nsw. */
+int add_one(int p[static 1])
+{
+  return p[0] + 1;
+}
+
+int main()
+{
+  int x = nondet_int();
+  /* Fails for x == INT_MAX. The nsw flag must not hide it. */
+  assert(add_one(&x) != INT_MIN);
+  return 0;
+}
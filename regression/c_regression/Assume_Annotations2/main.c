@@ -0,0 +1,20 @@
+#include <assert.h>
+
+int *nondet_pointer();
+
+/* p is noundef nonnull and dereferenceable, so it is not null. */
+__attribute__((noinline)) int first(int p[static 1])
+{
+  return p[0];
+}
+
+int main()
+{
+  int x = 1;
+  int *p = nondet_pointer();
+  __CPROVER_assume(p == &x || p == 0);
+  /* Passing null is undefined, so that path is assumed away
+     and the pointer check in first holds. */
+  assert(first(p) == 1);
+  return 0;
+}
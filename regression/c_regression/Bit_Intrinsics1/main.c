@@ -0,0 +1,113 @@
+#include <assert.h>
+
+unsigned nondet_uint();
+
+int popcount(unsigned x)
+{
+  return __builtin_popcount(x);
+}
+
+/* Zero is poison here: ctlz and cttz with the flag set. */
+int clz(unsigned x)
+{
+  return __builtin_clz(x);
+}
+
+int ctz(unsigned x)
+{
+  return __builtin_ctz(x);
+}
+
+/* Defined for zero: folded into ctlz and cttz with the flag clear. */
+int clz_or_width(unsigned x)
+{
+  return x ? __builtin_clz(x) : 32;
+}
+
+int ctz_or_width(unsigned x)
+{
+  return x ? __builtin_ctz(x) : 32;
+}
+
+unsigned short bswap16(unsigned short x)
+{
+  return __builtin_bswap16(x);
+}
+
+unsigned bswap32(unsigned x)
+{
+  return __builtin_bswap32(x);
+}
+
+unsigned long long bswap64(unsigned long long x)
+{
+  return __builtin_bswap64(x);
+}
+
+unsigned bitreverse(unsigned x)
+{
+  return __builtin_bitreverse32(x);
+}
+
+unsigned rotl(unsigned x, unsigned s)
+{
+  return __builtin_rotateleft32(x, s);
+}
+
+unsigned rotr(unsigned x, unsigned s)
+{
+  return __builtin_rotateright32(x, s);
+}
+
+/* A funnel shift of two different values. */
+unsigned funnel(unsigned a, unsigned b, unsigned s)
+{
+  s &= 31;
+  return s ? (a << s) | (b >> (32 - s)) : a;
+}
+
+int main()
+{
+  assert(popcount(0) == 0);
+  assert(popcount(0xffffffffu) == 32);
+  assert(popcount(0x80000001u) == 2);
+
+  assert(clz(1) == 31);
+  assert(clz(0x80000000u) == 0);
+  assert(ctz(0x80000000u) == 31);
+  assert(ctz(12) == 2);
+  assert(clz_or_width(0) == 32);
+  assert(ctz_or_width(0) == 32);
+  assert(clz_or_width(0x00f00000u) == 8);
+  assert(ctz_or_width(0x00f00000u) == 20);
+
+  assert(bswap16(0x1234) == 0x3412);
+  assert(bswap32(0x12345678u) == 0x78563412u);
+  assert(bswap64(0x0102030405060708ull) == 0x0807060504030201ull);
+
+  assert(bitreverse(1) == 0x80000000u);
+  assert(bitreverse(0x0000000fu) == 0xf0000000u);
+
+  assert(rotl(0x80000001u, 0) == 0x80000001u);
+  assert(rotl(0x80000001u, 1) == 0x00000003u);
+  assert(rotl(0x80000001u, 32) == 0x80000001u);
+  assert(rotl(0x80000001u, 33) == 0x00000003u);
+  assert(rotr(0x80000001u, 0) == 0x80000001u);
+  assert(rotr(0x80000001u, 1) == 0xc0000000u);
+  assert(rotr(0x80000001u, 32) == 0x80000001u);
+  assert(rotr(0x80000001u, 36) == 0x18000000u);
+
+  assert(funnel(0x12345678u, 0x9abcdef0u, 0) == 0x12345678u);
+  assert(funnel(0x12345678u, 0x9abcdef0u, 8) == 0x3456789au);
+  assert(funnel(0x12345678u, 0x9abcdef0u, 32) == 0x12345678u);
+  assert(funnel(0x12345678u, 0x9abcdef0u, 40) == 0x3456789au);
+
+  unsigned x = nondet_uint();
+  unsigned s = nondet_uint();
+  assert(popcount(x) + popcount(~x) == 32);
+  assert(clz_or_width(x) == 32 || clz(x) == clz_or_width(x));
+  assert(bitreverse(bitreverse(x)) == x);
+  assert(bswap32(bswap32(x)) == x);
+  assert(rotr(rotl(x, s), s) == x);
+  return 0;
+}
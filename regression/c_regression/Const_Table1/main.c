@@ -0,0 +1,40 @@
+#include <assert.h>
+
+int nondet_int();
+
+/* Mostly one value: an array_of updated at a few indices. */
+const int sparse[16] = {1, 1, 1, 7, 1, 1, 1, 1, 1, -2, 1, 1, 1, 1, 1, 5};
+/* No dominant value: an element-wise array. */
+const short dense[6] = {1, 2, 3, 4, 5, 6};
+const char *message = "hello";
+
+int lookup_sparse(int i)
+{
+  return sparse[i];
+}
+
+int lookup_dense(int i)
+{
+  return dense[i];
+}
+
+int main()
+{
+  int i = nondet_int();
+  __CPROVER_assume(i >= 0 && i < 16);
+  int v = lookup_sparse(i);
+  if (i == 3)
+    assert(v == 7);
+  else if (i == 9)
+    assert(v == -2);
+  else if (i == 15)
+    assert(v == 5);
+  else
+    assert(v == 1);
+
+  int j = nondet_int();
+  __CPROVER_assume(j >= 0 && j < 6);
+  assert(lookup_dense(j) == j + 1);
+  assert(message[1] == 'e' && message[5] == 0);
+  return 0;
+}
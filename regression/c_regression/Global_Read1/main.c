@@ -0,0 +1,22 @@
+#include <assert.h>
+
+int nondet_int();
+
+int table[2];
+
+// The load of table[1] uses a constant expression address.
+__attribute__((noinline)) int exchange()
+{
+  int old = table[1];
+  table[1] = 7;
+  return old;
+}
+
+int main()
+{
+  int x = nondet_int();
+  table[1] = x;
+  assert(exchange() == x);
+  assert(table[1] == 7);
+  return 0;
+}
@@ -0,0 +1,6 @@
+int hook(int x);
+
+int run(int x)
+{
+  return hook(x) * 2;
+}
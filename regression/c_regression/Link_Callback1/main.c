@@ -0,0 +1,18 @@
+#include <assert.h>
+
+int nondet_int();
+int run(int x);
+
+// Only run, in the other input, calls hook.
+int hook(int x)
+{
+  return x + 1;
+}
+
+int main()
+{
+  int x = nondet_int();
+  __CPROVER_assume(x >= 0 && x < 100);
+  assert(run(x) == 2 * x + 2);
+  return 0;
+}
@@ -0,0 +1,100 @@
+#include <assert.h>
+#include <string.h>
+
+int nondet_int();
+
+struct S
+{
+  int a;
+  int b[4];
+  char c;
+};
+
+struct S s1, s2, s3;
+int big[16];
+int small[8];
+char bytes[16];
+
+/* Same type on both sides: a typed assignment. */
+void copy_struct(void)
+{
+  s1 = s2;
+}
+
+/* The target is a whole array: array_copy. */
+void copy_into_array(void)
+{
+  memcpy(small, &big[2], sizeof(small));
+}
+
+/* The source is a whole array: array_replace. */
+void copy_from_array(void)
+{
+  memcpy(&big[4], small, sizeof(small));
+}
+
+/* Zeroing a whole object: its zero initializer. */
+void zero_struct(void)
+{
+  memset(&s3, 0, sizeof(s3));
+}
+
+/* A whole byte array: array_set. */
+void set_bytes(void)
+{
+  memset(bytes, 0x5a, sizeof(bytes));
+}
+
+/* Partial ranges fall back to a temporary byte array. */
+void partial(void)
+{
+  memset(&bytes[2], 1, 6);
+  memcpy(&small[1], &big[9], 12);
+}
+
+int main()
+{
+  for (int i = 0; i < 16; i++)
+    big[i] = i;
+  s2.a = nondet_int();
+  s2.b[3] = nondet_int();
+  s2.c = 'x';
+  s3.a = 7;
+  s3.b[1] = 8;
+  s3.c = 'y';
+
+  copy_struct();
+  assert(s1.a == s2.a);
+  assert(s1.b[3] == s2.b[3]);
+  assert(s1.c == 'x');
+
+  copy_into_array();
+  for (int i = 0; i < 8; i++)
+    assert(small[i] == i + 2);
+
+  copy_from_array();
+  assert(big[3] == 3);
+  for (int i = 0; i < 8; i++)
+    assert(big[i + 4] == i + 2);
+  assert(big[12] == 12);
+
+  zero_struct();
+  assert(s3.a == 0);
+  assert(s3.b[1] == 0);
+  assert(s3.c == 0);
+
+  set_bytes();
+  for (int i = 0; i < 16; i++)
+    assert(bytes[i] == 0x5a);
+
+  partial();
+  assert(bytes[1] == 0x5a);
+  for (int i = 2; i < 8; i++)
+    assert(bytes[i] == 1);
+  assert(bytes[8] == 0x5a);
+  assert(small[0] == 2);
+  assert(small[1] == big[9]);
+  assert(small[3] == big[11]);
+  assert(small[4] == 6);
+  return 0;
+}
@@ -0,0 +1,18 @@
+#include <assert.h>
+
+int nondet_int();
+
+static void set(int *p, int v)
+{
+  *p = v;
+}
+
+int main()
+{
+  int x = nondet_int();
+  int y = x + 1;
+  set(&x, y);
+  assert(x == y);
+  assert(y - 1 != x);
+  return 0;
+}
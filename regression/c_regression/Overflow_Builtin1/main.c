@@ -0,0 +1,18 @@
+int nondet();
+
+int main()
+{
+  int x = nondet();
+  int r;
+
+  if (__builtin_add_overflow(x, 1, &r))
+    assert(x == 2147483647);
+  else
+    assert(r == x + 1);
+
+  unsigned u = nondet();
+  unsigned s;
+  if (!__builtin_mul_overflow(u, 2u, &s))
+    assert(s >= u);
+  return 0;
+}
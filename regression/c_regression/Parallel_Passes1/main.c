@@ -0,0 +1,34 @@
+#include <assert.h>
+
+static int counter;
+static const int squares[5] = {0, 1, 4, 9, 16};
+
+static int next(void)
+{
+  return ++counter;
+}
+
+int square(int x)
+{
+  if (x >= 0 && x < 5)
+    return squares[x];
+  return x * x;
+}
+
+int sum_squares(int n)
+{
+  int s = 0;
+  for (int i = 0; i < n; i++)
+    s += square(i);
+  return s;
+}
+
+int main()
+{
+  next();
+  next();
+  assert(counter == 2);
+  assert(sum_squares(4) == 14);
+  assert(square(7) == 49);
+  return 0;
+}
@@ -0,0 +1,21 @@
+#include <assert.h>
+
+int nondet_int();
+
+// The old value is read through a pointer argument and must be
+// kept across the store through the same pointer.
+__attribute__((noinline)) int exchange(int *p)
+{
+  int old = *p;
+  *p = 5;
+  return old;
+}
+
+int main()
+{
+  int x = nondet_int();
+  int y = x;
+  assert(exchange(&y) == x);
+  assert(y == 5);
+  return 0;
+}
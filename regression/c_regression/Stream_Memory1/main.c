@@ -0,0 +1,29 @@
+#include <assert.h>
+
+// Many functions with long bodies, so the translated program
+// is large next to any single function.
+#define STEP(k) x = x * 3 + (k); if (x > (k)) x -= (k);
+#define STEPS(k) STEP(k) STEP(k + 1) STEP(k + 2) STEP(k + 3) STEP(k + 4)
+#define BODY STEPS(0) STEPS(5) STEPS(10) STEPS(15) STEPS(20) STEPS(25)
+#define FUNC(n) int f##n(int x) { BODY return x + n; }
+#define FUNCS(n) FUNC(n##0) FUNC(n##1) FUNC(n##2) FUNC(n##3) FUNC(n##4) \
+                 FUNC(n##5) FUNC(n##6) FUNC(n##7) FUNC(n##8) FUNC(n##9)
+#define FUNCS10(n) FUNCS(n##0) FUNCS(n##1) FUNCS(n##2) FUNCS(n##3) \
+                   FUNCS(n##4) FUNCS(n##5) FUNCS(n##6) FUNCS(n##7) \
+                   FUNCS(n##8) FUNCS(n##9)
+
+FUNCS10(1)
+FUNCS10(2)
+FUNCS10(3)
+FUNCS10(4)
+
+int nondet_int();
+
+int main()
+{
+  int x = nondet_int();
+  __CPROVER_assume(x >= 0 && x < 100);
+  assert(f100(0) == f100(0));
+  assert(f499(x) == f499(x));
+  return 0;
+}
@@ -0,0 +1,24 @@
+#include <assert.h>
+
+int table[4] = {1, 2, 3, 4};
+
+int sum(int *a, int n)
+{
+  int s = 0;
+  for (int i = 0; i < n; i++)
+    s += a[i];
+  return s;
+}
+
+int twice(int x)
+{
+  return x + x;
+}
+
+int main()
+{
+  int s = sum(table, 4);
+  assert(s == 10);
+  assert(twice(s) == 20);
+  return 0;
+}
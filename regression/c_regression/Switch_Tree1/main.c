@@ -0,0 +1,53 @@
+#include <assert.h>
+
+int nondet_int();
+
+int c0, c1, c2, c3, c4, c5, c6, cd;
+
+void classify(int x, int y)
+{
+  switch ((x ^ y) % 1009)
+  {
+  case -20:
+    c0++;
+    break;
+  case 0:
+    c1++;
+    break;
+  case 7:
+  case 100:
+    c2++;
+    break;
+  case 10 ... 14:
+    c3++;
+    break;
+  case 20 ... 22:
+    c4++;
+    break;
+  case 30:
+    c5++;
+    break;
+  case 1000:
+    c6++;
+    break;
+  default:
+    cd++;
+  }
+}
+
+int main()
+{
+  int x = nondet_int();
+  int y = nondet_int();
+  int v = (x ^ y) % 1009;
+  classify(x, y);
+  assert(c0 == (v == -20));
+  assert(c1 == (v == 0));
+  assert(c2 == (v == 7 || v == 100));
+  assert(c3 == (v >= 10 && v <= 14));
+  assert(c4 == (v >= 20 && v <= 22));
+  assert(c5 == (v == 30));
+  assert(c6 == (v == 1000));
+  assert(c0 + c1 + c2 + c3 + c4 + c5 + c6 + cd == 1);
+  return 0;
+}
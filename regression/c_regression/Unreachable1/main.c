@@ -0,0 +1,13 @@
+int nondet();
+
+int main()
+{
+  int x = nondet();
+
+  if (x > 10)
+    __builtin_unreachable();
+
+  // paths through the unreachable are cut
+  assert(x <= 10);
+  return 0;
+}
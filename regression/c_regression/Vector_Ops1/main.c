@@ -0,0 +1,91 @@
+#include <assert.h>
+
+typedef int v4si __attribute__((vector_size(16)));
+typedef float v4sf __attribute__((vector_size(16)));
+typedef unsigned char v4qi __attribute__((vector_size(4)));
+
+int nondet_int();
+
+v4si arith(v4si a, v4si b)
+{
+  return a * b + a / b - a % b;
+}
+
+v4si compare(v4si a, v4si b)
+{
+  return a < b;
+}
+
+v4si shuffle(v4si a, v4si b)
+{
+  return __builtin_shufflevector(a, b, 0, 5, 2, 7);
+}
+
+v4si insert(v4si a, int x)
+{
+  a[2] = x;
+  return a;
+}
+
+int extract(v4si a, int i)
+{
+  return a[i & 3];
+}
+
+unsigned to_int(v4qi q)
+{
+  return (unsigned)q;
+}
+
+v4qi from_int(unsigned u)
+{
+  return (v4qi)u;
+}
+
+v4sf to_float(v4si a)
+{
+  return __builtin_convertvector(a, v4sf);
+}
+
+v4si to_int_lanes(v4sf f)
+{
+  return __builtin_convertvector(f, v4si);
+}
+
+int main()
+{
+  v4si a, b;
+  for (int i = 0; i < 4; i++)
+  {
+    a[i] = nondet_int();
+    b[i] = nondet_int();
+    __CPROVER_assume(a[i] > -1000 && a[i] < 1000);
+    __CPROVER_assume(b[i] > 0 && b[i] < 100);
+  }
+
+  v4si r = arith(a, b);
+  for (int i = 0; i < 4; i++)
+    assert(r[i] == a[i] * b[i] + a[i] / b[i] - a[i] % b[i]);
+
+  v4si c = compare(a, b);
+  for (int i = 0; i < 4; i++)
+    assert(c[i] == (a[i] < b[i] ? -1 : 0));
+
+  v4si s = shuffle(a, b);
+  assert(s[0] == a[0] && s[1] == b[1] && s[2] == a[2] && s[3] == b[3]);
+
+  v4si n = insert(a, 42);
+  assert(n[0] == a[0] && n[1] == a[1] && n[2] == 42 && n[3] == a[3]);
+  assert(extract(a, 3) == a[3]);
+
+  v4qi q = {0x11, 0x22, 0x33, 0x44};
+  assert(to_int(q) == 0x44332211u);
+  v4qi p = from_int(0xa1b2c3d4u);
+  assert(p[0] == 0xd4 && p[1] == 0xc3 && p[2] == 0xb2 && p[3] == 0xa1);
+
+  v4sf f = to_float(a);
+  v4si back = to_int_lanes(f);
+  for (int i = 0; i < 4; i++)
+    assert(back[i] == a[i]);
+  return 0;
+}
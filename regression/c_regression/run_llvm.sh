@@ -1,9 +1,71 @@
 #!/bin/bash
 
+# A test directory may hold, next to main.c:
+#   inputs/*.c     more sources, translated as further ll2gb inputs
+#   ll2gb.options  extra ll2gb options used for main.c.i
+#   ll2gb.compare  one set of ll2gb options per line; the GOTO program
+#                  translated with each set must match main.c.i
+#   ll2gb.verify   cbmc options; ll2gb -verify must exit like cbmc does
+#   ll2gb.memory   ll2gb options that must lower the peak memory of the
+#                  translation, checked when /usr/bin/time is available
+
+status=0
+
 for file in */*.c
 do
+   dir=$(dirname ${file})
+   options=""
+   if [ -f ${dir}/ll2gb.options ]; then
+      options=$(cat ${dir}/ll2gb.options)
+   fi
    rm ${file}".i" -f
    rm ${file}".ll" -f
    clang -S -emit-llvm -Xclang -disable-O0-optnone ${file} -o ${file}".ll" -Wno-everything
-   ../../build/ll2gb -o ${file}".i" ${file}".ll" -vv -opt
+   inputs=""
+   for input in $(ls ${dir}/inputs/*.c 2> /dev/null)
+   do
+      rm ${input}".ll" -f
+      clang -S -emit-llvm -Xclang -disable-O0-optnone ${input} -o ${input}".ll" -Wno-everything
+      inputs="${inputs} ${input}.ll"
+   done
+   ../../build/ll2gb -o ${file}".i" ${file}".ll" ${inputs} -vv -opt ${options}
+
+   if [ -f ${dir}/ll2gb.compare ]; then
+      cbmc --show-goto-functions ${file}".i" > ${file}".goto"
+      while read -r compare; do
+         [ -z "${compare}" ] && continue
+         rm ${file}".cmp.i" -f
+         ../../build/ll2gb -o ${file}".cmp.i" ${file}".ll" ${inputs} -opt ${options} ${compare}
+         cbmc --show-goto-functions ${file}".cmp.i" > ${file}".cmp.goto"
+         if ! diff -q ${file}".goto" ${file}".cmp.goto" > /dev/null; then
+            echo "${dir}: output with ${compare} differs"
+            status=1
+         fi
+      done < ${dir}/ll2gb.compare
+   fi
+
+   if [ -f ${dir}/ll2gb.verify ]; then
+      cbmc_options=$(cat ${dir}/ll2gb.verify)
+      cbmc ${cbmc_options} ${file}".i" > /dev/null
+      expected=$?
+      ../../build/ll2gb -verify -cbmc-options "${cbmc_options}" ${file}".ll" ${inputs} -opt ${options} > /dev/null
+      actual=$?
+      if [ ${expected} -ne ${actual} ]; then
+         echo "${dir}: -verify exited with ${actual}, cbmc with ${expected}"
+         status=1
+      fi
+   fi
+
+   if [ -f ${dir}/ll2gb.memory ] && [ -x /usr/bin/time ]; then
+      memory_options=$(cat ${dir}/ll2gb.memory)
+      rm ${file}".mem.i" -f
+      before=$(/usr/bin/time -f %M ../../build/ll2gb -o ${file}".mem.i" ${file}".ll" ${inputs} -opt ${options} 2>&1 > /dev/null | tail -n 1)
+      after=$(/usr/bin/time -f %M ../../build/ll2gb -o ${file}".mem.i" ${file}".ll" ${inputs} -opt ${options} ${memory_options} 2>&1 > /dev/null | tail -n 1)
+      if [ ${after} -ge ${before} ]; then
+         echo "${dir}: peak memory with ${memory_options} is ${after}K, without ${before}K"
+         status=1
+      fi
+   fi
 done
+
+exit ${status}
@@ -0,0 +1,48 @@
+/*
+ * arena_allocator.h
+ */
+
+#ifndef ARENA_ALLOCATOR_H
+#define ARENA_ALLOCATOR_H
+
+#include <llvm/Support/Allocator.h>
+
+#include <map>
+
+namespace ll2gb {
+
+/// A standard allocator handing out memory from a
+/// BumpPtrAllocator. Deallocation is a no-op, the memory is
+/// released all at once when the arena is reset.
+template <typename T> class arena_allocator {
+  template <typename U> friend class arena_allocator;
+  llvm::BumpPtrAllocator *arena;
+
+public:
+  using value_type = T;
+
+  arena_allocator(llvm::BumpPtrAllocator &A) : arena{&A} {}
+  template <typename U>
+  arena_allocator(const arena_allocator<U> &other) : arena{other.arena} {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(arena->Allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *, std::size_t) {}
+
+  template <typename U> bool operator==(const arena_allocator<U> &other) const {
+    return arena == other.arena;
+  }
+  template <typename U> bool operator!=(const arena_allocator<U> &other) const {
+    return arena != other.arena;
+  }
+};
+
+/// A std::map whose nodes live in an arena.
+template <typename K, typename V>
+using arena_map =
+    std::map<K, V, std::less<K>, arena_allocator<std::pair<const K, V>>>;
+
+} // namespace ll2gb
+
+#endif /* ARENA_ALLOCATOR_H */
@@ -0,0 +1,330 @@
+/*
+ * compressed_goto.cpp
+ */
+
+#include "ll2gb.h"
+#include "translator.h"
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/Compression.h>
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <cstring>
+#include <sstream>
+
+using namespace std;
+using namespace llvm;
+using namespace ll2gb;
+
+/// A compressed GOTO container looks like
+///
+///   "\x7fGBZ" version goto-binary-version
+///   symbol frame, function frames...
+///   index: (name-size name offset size raw-size)...
+///   footer: symbols-offset symbols-size symbols-raw-size
+///           index-offset function-count "GBZI"
+///
+/// Numbers are 64 bit little endian. Every frame is a zlib
+/// compressed, self contained GOTO binary; the symbol frame
+/// holds the whole symbol table and each function frame a
+/// single function, so a reader can decode just the
+/// functions it needs.
+static const uint64_t compressed_goto_version = 1;
+static const char compressed_goto_magic[] = "\x7fGBZ";
+static const char compressed_goto_index_magic[] = "GBZI";
+static const size_t compressed_goto_header_size = 4 + 2 * 8;
+static const size_t compressed_goto_footer_size = 5 * 8 + 4;
+
+namespace {
+struct framet {
+  uint64_t offset = 0;
+  uint64_t size = 0;
+  uint64_t raw_size = 0;
+};
+} // namespace
+
+static void write_u64(ostream &out, uint64_t value) {
+  char bytes[8];
+  support::endian::write64le(bytes, value);
+  out.write(bytes, 8);
+}
+
+static uint64_t read_u64(const char *&pos) {
+  auto value = support::endian::read64le(pos);
+  pos += 8;
+  return value;
+}
+
+/// zlib moved to llvm::compression and to byte buffers in
+/// LLVM 15; these wrap both interfaces.
+static bool zlib_available() {
+#if LLVM_VERSION_MAJOR >= 15
+  return compression::zlib::isAvailable();
+#else
+  return zlib::isAvailable();
+#endif
+}
+
+static Error zlib_compress(StringRef data, SmallVectorImpl<char> &out) {
+#if LLVM_VERSION_MAJOR >= 15
+  SmallVector<uint8_t, 0> compressed;
+  compression::zlib::compress(arrayRefFromStringRef(data), compressed);
+  out.assign(compressed.begin(), compressed.end());
+  return Error::success();
+#else
+  return zlib::compress(data, out);
+#endif
+}
+
+static Error zlib_uncompress(StringRef data, SmallVectorImpl<char> &out,
+                             size_t raw_size) {
+#if LLVM_VERSION_MAJOR >= 15
+  SmallVector<uint8_t, 0> raw;
+  if (auto E = compression::zlib::uncompress(arrayRefFromStringRef(data), raw,
+                                             raw_size))
+    return E;
+  out.assign(raw.begin(), raw.end());
+  return Error::success();
+#else
+  return zlib::uncompress(data, out, raw_size);
+#endif
+}
+
+/// Compresses data and appends it to out as the frame f.
+static bool write_frame(ostream &out, uint64_t &offset, const string &data,
+                        framet &f) {
+  SmallVector<char, 0> compressed;
+  if (auto E = zlib_compress(data, compressed)) {
+    translator::error_state = toString(std::move(E));
+    return true;
+  }
+  out.write(compressed.data(), compressed.size());
+  f.offset = offset;
+  f.size = compressed.size();
+  f.raw_size = data.size();
+  offset += f.size;
+  return false;
+}
+
+/// Returns a copy of symbol_table whose function symbols have
+/// an empty value. The function frames hold the code already.
+static symbol_tablet
+without_function_values(const symbol_tablet &symbol_table) {
+  symbol_tablet stripped;
+  for (const auto &entry : symbol_table.symbols) {
+    symbolt symbol = entry.second;
+    if (symbol.type.id() == ID_code && symbol.value.is_not_nil())
+      symbol.value = code_blockt();
+    stripped.add(symbol);
+  }
+  return stripped;
+}
+
+/// Writes the compressed GOTO container. Functions are
+/// taken from memory or, with -stream, from the spool file.
+bool translator::write_goto_compressed(ostream &out) {
+  if (!zlib_available()) {
+    error_state = "Compressed output needs LLVM built with zlib";
+    return true;
+  }
+  out.write(compressed_goto_magic, 4);
+  write_u64(out, compressed_goto_version);
+  write_u64(out, GOTO_BINARY_VERSION);
+  uint64_t offset = compressed_goto_header_size;
+
+  framet symbols;
+  {
+    stringstream ss;
+    write_goto_binary(ss, without_function_values(symbol_table),
+                      goto_functionst());
+    if (write_frame(out, offset, ss.str(), symbols))
+      return true;
+  }
+
+  vector<pair<irep_idt, framet>> index;
+  for (auto &function : goto_functions.function_map) {
+    if (!function.second.body_available())
+      continue;
+    index.emplace_back(function.first, framet());
+    if (write_frame(out, offset,
+                    encode_function(function.first, function.second.body),
+                    index.back().second))
+      return true;
+  }
+  if (spool_file)
+    rewind(spool_file);
+  string data;
+  for (const auto &spooled : spooled_functions) {
+    if (read_spooled_function(spooled, data))
+      return true;
+    index.emplace_back(spooled.first, framet());
+    if (write_frame(out, offset, data, index.back().second))
+      return true;
+  }
+
+  const uint64_t index_offset = offset;
+  for (const auto &entry : index) {
+    const auto &name = id2string(entry.first);
+    write_u64(out, name.size());
+    out.write(name.data(), name.size());
+    write_u64(out, entry.second.offset);
+    write_u64(out, entry.second.size);
+    write_u64(out, entry.second.raw_size);
+  }
+  write_u64(out, symbols.offset);
+  write_u64(out, symbols.size);
+  write_u64(out, symbols.raw_size);
+  write_u64(out, index_offset);
+  write_u64(out, index.size());
+  out.write(compressed_goto_index_magic, 4);
+  return !out.good();
+}
+
+/// Decompresses the frame f of buffer and decodes the GOTO
+/// binary in it into symbol_table and goto_functions.
+static bool read_frame(const MemoryBuffer &buffer, const framet &f,
+                       const string &file_name, symbol_tablet &symbol_table,
+                       goto_functionst &goto_functions,
+                       message_handlert &msg_handler) {
+  if (f.offset + f.size > buffer.getBufferSize()) {
+    translator::error_state = "Truncated frame in " + file_name;
+    return true;
+  }
+  SmallVector<char, 0> raw;
+  if (auto E = zlib_uncompress(buffer.getBuffer().substr(f.offset, f.size),
+                               raw, f.raw_size)) {
+    translator::error_state = toString(std::move(E));
+    return true;
+  }
+  istringstream in(string(raw.data(), raw.size()));
+  if (read_bin_goto_object(in, file_name, symbol_table, goto_functions,
+                           msg_handler)) {
+    translator::error_state = "Unable to decode frame in " + file_name;
+    return true;
+  }
+  return false;
+}
+
+/// Loads the symbol table and the named functions from the
+/// compressed GOTO container file_name, or every function if
+/// functions is empty. The file is memory mapped and only the
+/// frames asked for are decompressed. Returns true on failure.
+bool ll2gb::read_compressed_goto(const string &file_name,
+                                 const vector<string> &functions,
+                                 symbol_tablet &symbol_table,
+                                 goto_functionst &goto_functions,
+                                 message_handlert &msg_handler) {
+  if (!zlib_available()) {
+    translator::error_state = "Compressed input needs LLVM built with zlib";
+    return true;
+  }
+  auto buffer_or_err = MemoryBuffer::getFile(file_name, false, false);
+  if (!buffer_or_err) {
+    translator::error_state = "Unable to open " + file_name + ": " +
+                              buffer_or_err.getError().message();
+    return true;
+  }
+  const auto &buffer = **buffer_or_err;
+  const char *start = buffer.getBufferStart();
+  const size_t size = buffer.getBufferSize();
+  if (size < compressed_goto_header_size + compressed_goto_footer_size ||
+      memcmp(start, compressed_goto_magic, 4) ||
+      memcmp(buffer.getBufferEnd() - 4, compressed_goto_index_magic, 4)) {
+    translator::error_state = file_name + " is not a compressed GOTO binary";
+    return true;
+  }
+  const char *pos = start + 4;
+  if (read_u64(pos) != compressed_goto_version) {
+    translator::error_state =
+        "Unsupported compressed GOTO binary version in " + file_name;
+    return true;
+  }
+
+  pos = buffer.getBufferEnd() - compressed_goto_footer_size;
+  framet symbols;
+  symbols.offset = read_u64(pos);
+  symbols.size = read_u64(pos);
+  symbols.raw_size = read_u64(pos);
+  const uint64_t index_offset = read_u64(pos);
+  const uint64_t count = read_u64(pos);
+  if (index_offset > size - compressed_goto_footer_size) {
+    translator::error_state = "Corrupt index in " + file_name;
+    return true;
+  }
+
+  const char *index_end = buffer.getBufferEnd() - compressed_goto_footer_size;
+  map<StringRef, framet> index;
+  pos = start + index_offset;
+  for (uint64_t i = 0; i < count; i++) {
+    if (index_end - pos < 8) {
+      translator::error_state = "Corrupt index in " + file_name;
+      return true;
+    }
+    const uint64_t name_size = read_u64(pos);
+    if ((uint64_t)(index_end - pos) < name_size + 3 * 8) {
+      translator::error_state = "Corrupt index in " + file_name;
+      return true;
+    }
+    StringRef name(pos, name_size);
+    pos += name_size;
+    auto &f = index[name];
+    f.offset = read_u64(pos);
+    f.size = read_u64(pos);
+    f.raw_size = read_u64(pos);
+  }
+
+  if (read_frame(buffer, symbols, file_name, symbol_table, goto_functions,
+                 msg_handler))
+    return true;
+  if (functions.empty()) {
+    for (const auto &entry : index)
+      if (read_frame(buffer, entry.second, file_name, symbol_table,
+                     goto_functions, msg_handler))
+        return true;
+    return false;
+  }
+  for (const auto &function : functions) {
+    auto entry = index.find(function);
+    if (entry == index.end()) {
+      translator::error_state =
+          "Function " + function + " not found in " + file_name;
+      return true;
+    }
+    if (read_frame(buffer, entry->second, file_name, symbol_table,
+                   goto_functions, msg_handler))
+      return true;
+  }
+  return false;
+}
+
+/// Writes the functions selected with -functions from the
+/// compressed GOTO container in_file as a plain GOTO binary.
+bool ll2gb::unpack_goto(const string &in_file, const string &out_file) {
+  if (verbose) {
+    outs().changeColor(outs().SAVEDCOLOR, true);
+    outs() << "Unpacking GOTO Binary to: " << out_file;
+    outs().resetColor();
+  }
+  null_message_handlert msg_handler;
+  symbol_tablet symbol_table;
+  goto_functionst goto_functions;
+  vector<string> functions(unpackFunctions.begin(), unpackFunctions.end());
+  bool failed = read_compressed_goto(in_file, functions, symbol_table,
+                                     goto_functions, msg_handler);
+  if (!failed) {
+    ofstream out(out_file, ios::binary);
+    failed = write_goto_binary(out, symbol_table, goto_functions);
+    if (failed)
+      translator::error_state = "Unable to write GOTO binary: " + out_file;
+  }
+  if (verbose) {
+    outs() << "  [";
+    outs().changeColor(failed ? outs().RED : outs().GREEN, true);
+    outs() << (failed ? "FAILED" : "OK");
+    outs().resetColor();
+    outs() << "]\n";
+  }
+  return failed;
+}
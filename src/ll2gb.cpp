@@ -17,13 +17,25 @@ int main(int argc, char **argv) {
 
   parse_input(argc, argv);
 
+  if (unpackInput) {
+    if (unpack_goto(InputFilenames.front(), outputFilename)) {
+      print_error();
+      return CPROVER_EXIT_INTERNAL_ERROR;
+    }
+    return 0;
+  }
+
   auto ir_module = get_llvm_ir();
 
-  run_llvm_passes(*ir_module);
+  run_llvm_passes(ir_module);
 
   translator T(ir_module);
-  if (T.generate_goto())
+  if (T.generate_goto()) {
     print_error();
+    if (verifyMode)
+      return CPROVER_EXIT_INTERNAL_ERROR;
+  } else if (verifyMode)
+    return T.verify_goto();
   else
     T.write_goto(outputFilename);
   return 0;
@@ -11,6 +11,10 @@
 #include <stdarg.h>
 
 #include <llvm-c/Core.h>
+#include <llvm/Analysis/CaptureTracking.h>
+#include <llvm/Analysis/ConstantFolding.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/DebugInfoMetadata.h>
 #include <llvm/IR/Function.h>
@@ -23,9 +27,11 @@
 #include <llvm/IR/Module.h>
 #include <llvm/IR/PassManager.h>
 #include <llvm/IRReader/IRReader.h>
+#include <llvm/Linker/Linker.h>
 #include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/ThreadPool.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Transforms/IPO.h>
 #include <llvm/Transforms/IPO/AlwaysInliner.h>
@@ -35,14 +41,21 @@
 #include <llvm/Transforms/Scalar/IndVarSimplify.h>
 #include <llvm/Transforms/Scalar/LoopStrengthReduce.h>
 #include <llvm/Transforms/Utils.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
 
 #include <ansi-c/ansi_c_entry_point.h>
 #include <ansi-c/ansi_c_language.h>
 #include <ansi-c/cprover_library.h>
 #include <cbmc/cbmc_parse_options.h>
+#include <goto-checker/all_properties_verifier_with_trace_storage.h>
+#include <goto-checker/multi_path_symex_checker.h>
+#include <goto-checker/stop_on_fail_verifier.h>
 #include <goto-instrument/function.h>
+#include <goto-programs/goto_convert_functions.h>
 #include <goto-programs/goto_model.h>
 #include <goto-programs/goto_program.h>
+#include <goto-programs/read_bin_goto_object.h>
 #include <goto-programs/remove_skip.h>
 #include <goto-programs/write_goto_binary.h>
 #include <langapi/language_util.h>
@@ -51,10 +64,15 @@
 #include <solvers/floatbv/float_bv.h>
 #include <util/arith_tools.h>
 #include <util/bitvector_expr.h>
+#include <util/byte_operators.h>
 #include <util/c_types.h>
 #include <util/config.h>
+#include <util/exit_codes.h>
 #include <util/expr.h>
+#include <util/expr_initializer.h>
 #include <util/floatbv_expr.h>
+#include <util/irep_hash_container.h>
+#include <util/irep_serialization.h>
 #include <util/message.h>
 #include <util/namespace.h>
 #include <util/std_code.h>
@@ -66,13 +84,28 @@ extern llvm::cl::opt<bool> verbose;
 extern llvm::cl::opt<bool> verbose_very;
 extern llvm::cl::opt<bool> optEnabled;
 extern llvm::cl::opt<bool> optimizeForced;
+extern llvm::cl::opt<unsigned> passThreads;
+extern llvm::cl::opt<bool> streamOutput;
+extern llvm::cl::opt<unsigned> switchTreeThreshold;
+extern llvm::cl::opt<bool> compressOutput;
+extern llvm::cl::opt<bool> unpackInput;
+extern llvm::cl::list<std::string> unpackFunctions;
+extern llvm::cl::opt<bool> verifyMode;
+extern llvm::cl::opt<std::string> cbmcOptions;
+extern llvm::cl::opt<bool> unreachableAssert;
+extern llvm::cl::opt<bool> assumeAnnotations;
 extern llvm::cl::opt<std::string> outputFilename;
-extern llvm::cl::opt<std::string> InputFilename;
+extern llvm::cl::list<std::string> InputFilenames;
 
 class translator;
 
 std::unique_ptr<llvm::Module> get_llvm_ir();
-bool run_llvm_passes(llvm::Module &);
+bool run_llvm_passes(std::unique_ptr<llvm::Module> &);
+
+bool read_compressed_goto(const std::string &,
+                          const std::vector<std::string> &, symbol_tablet &,
+                          goto_functionst &, message_handlert &);
+bool unpack_goto(const std::string &, const std::string &);
 
 bool is_assume_function(const std::string &);
 bool is_assert_function(const std::string &);
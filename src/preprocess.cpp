@@ -11,22 +11,24 @@ using namespace std;
 using namespace llvm;
 using namespace ll2gb;
 
-/// Return an llvm ir from input file_name.
-/// LLVMContext is provided separately.
-unique_ptr<Module> ll2gb::get_llvm_ir() {
+/// Reads the llvm ir in file_name, exits on failure.
+/// Bitcode read lazily only has its function bodies
+/// materialized when they are requested.
+static unique_ptr<Module> read_ir_file(const string &file_name,
+                                       LLVMContext &context, bool lazy) {
   if (verbose) {
     outs().changeColor(raw_ostream::Colors::SAVEDCOLOR, true);
-    outs() << "Reading llvm IR: " << InputFilename;
+    outs() << "Reading llvm IR: " << file_name;
     outs().resetColor();
   }
   SMDiagnostic err;
-  static LLVMContext context;
-  auto M = parseIRFile(InputFilename, err, context);
+  auto M = lazy ? getLazyIRFileModule(file_name, err, context)
+                : parseIRFile(file_name, err, context);
 
   if (!M) {
     if (!verbose) {
       outs().changeColor(raw_ostream::Colors::SAVEDCOLOR, true);
-      outs() << "Reading llvm IR: " << InputFilename;
+      outs() << "Reading llvm IR: " << file_name;
       outs().resetColor();
     }
     outs() << "  [";
@@ -34,7 +36,7 @@ unique_ptr<Module> ll2gb::get_llvm_ir() {
     outs() << "FAILED";
     outs().resetColor();
     outs() << "]\n";
-    err.print(InputFilename.c_str(), outs());
+    err.print(file_name.c_str(), outs());
     exit(1);
   }
   if (verbose) {
@@ -47,6 +49,150 @@ unique_ptr<Module> ll2gb::get_llvm_ir() {
   return M;
 }
 
+/// Returns true if Src defines a symbol that is
+/// only declared in the composite module M.
+static bool provides_needed_symbol(const Module &M, const Module &Src) {
+  for (const auto &GV : Src.global_values()) {
+    if (GV.isDeclaration() || GV.hasLocalLinkage())
+      continue;
+    const auto *DGV = M.getNamedValue(GV.getName());
+    if (DGV && DGV->isDeclaration())
+      return true;
+  }
+  return false;
+}
+
+/// Links the remaining input files, loaded lazily into pending,
+/// into M in memory. Each file is linked with LinkOnlyNeeded,
+/// so only the definitions M still refers to get materialized.
+/// Since linking can introduce new references, the pending
+/// files are revisited until no file provides anything new.
+/// A file is dropped from pending once it has been linked in.
+static void link_ir_files(Module &M,
+                          vector<pair<string, unique_ptr<Module>>> &pending) {
+  Linker L(M);
+  bool linked = true;
+  while (linked) {
+    linked = false;
+    for (auto it = pending.begin(); it != pending.end();) {
+      const auto &file_name = it->first;
+      if (!provides_needed_symbol(M, *it->second)) {
+        ++it;
+        continue;
+      }
+      if (L.linkInModule(std::move(it->second),
+                         Linker::Flags::LinkOnlyNeeded)) {
+        outs().changeColor(raw_ostream::Colors::SAVEDCOLOR, true);
+        outs() << "Linking llvm IR: " << file_name;
+        outs().resetColor();
+        outs() << "  [";
+        outs().changeColor(outs().RED, true);
+        outs() << "FAILED";
+        outs().resetColor();
+        outs() << "]\n";
+        exit(1);
+      }
+      it = pending.erase(it);
+      linked = true;
+    }
+  }
+}
+
+static void materialize_failed(Error Err) {
+  errs().changeColor(errs().RED, true);
+  errs() << "error: ";
+  errs().resetColor();
+  logAllUnhandledErrors(std::move(Err), errs());
+  exit(1);
+}
+
+/// Pushes every GlobalValue that C refers to onto worklist.
+static void collect_global_refs(const Constant &C,
+                                SmallVectorImpl<GlobalValue *> &worklist,
+                                SmallPtrSetImpl<const Constant *> &seen) {
+  if (!seen.insert(&C).second)
+    return;
+  if (isa<GlobalValue>(C)) {
+    worklist.push_back(const_cast<GlobalValue *>(cast<GlobalValue>(&C)));
+    return;
+  }
+  for (const auto &U : C.operands())
+    if (isa<Constant>(U))
+      collect_global_refs(*cast<Constant>(U), worklist, seen);
+}
+
+/// Materializes only the functions reachable from the entry
+/// point, following calls, address-taken functions and global
+/// initializers. The definitions the other inputs refer to,
+/// e.g. a callback called by a library, are reachable as well,
+/// since they may be needed once those inputs are linked in.
+/// The bodies of all other functions are never read, and the
+/// declarations left unreferenced are removed.
+static void
+materialize_reachable(Module &M,
+                      const vector<pair<string, unique_ptr<Module>>> &others) {
+  auto *entry = M.getFunction("main");
+  if (!entry)
+    entry = M.getFunction("MAIN_");
+  if (!entry) {
+    if (auto Err = M.materializeAll())
+      materialize_failed(std::move(Err));
+    return;
+  }
+  SmallPtrSet<const GlobalValue *, 32> reachable;
+  SmallPtrSet<const Constant *, 32> seen;
+  SmallVector<GlobalValue *, 32> worklist{entry};
+  for (const auto &other : others)
+    for (const auto &GV : other.second->global_values())
+      if (GV.isDeclaration())
+        if (auto *DGV = M.getNamedValue(GV.getName()))
+          worklist.push_back(DGV);
+  while (!worklist.empty()) {
+    auto *GV = worklist.pop_back_val();
+    if (!reachable.insert(GV).second)
+      continue;
+    if (auto Err = GV->materialize())
+      materialize_failed(std::move(Err));
+    if (auto *F = dyn_cast<Function>(GV)) {
+      for (const auto &BB : *F)
+        for (const auto &I : BB)
+          for (const auto &U : I.operands())
+            if (isa<Constant>(U))
+              collect_global_refs(*cast<Constant>(U), worklist, seen);
+    } else if (auto *G = dyn_cast<GlobalVariable>(GV)) {
+      if (G->hasInitializer())
+        collect_global_refs(*G->getInitializer(), worklist, seen);
+    } else if (auto *GA = dyn_cast<GlobalAlias>(GV))
+      collect_global_refs(*GA->getAliasee(), worklist, seen);
+  }
+  for (auto &F : M)
+    if (F.isMaterializable() && !reachable.count(&F))
+      F.deleteBody();
+  for (auto &F : make_early_inc_range(M))
+    if (!reachable.count(&F) && F.isDeclaration() && F.use_empty())
+      F.eraseFromParent();
+  /// Nothing is left to materialize, this only finalizes the
+  /// module (metadata, auto-upgrades) and drops the reader.
+  if (auto Err = M.materializeAll())
+    materialize_failed(std::move(Err));
+}
+
+/// Return an llvm ir from the input files. The first
+/// input is the entry module, the rest are linked into it.
+/// LLVMContext is provided separately.
+unique_ptr<Module> ll2gb::get_llvm_ir() {
+  static LLVMContext context;
+  auto M = read_ir_file(InputFilenames.front(), context, true);
+  vector<pair<string, unique_ptr<Module>>> others;
+  for (auto file = InputFilenames.begin() + 1; file != InputFilenames.end();
+       ++file)
+    others.emplace_back(*file, read_ir_file(*file, context, true));
+  materialize_reachable(*M, others);
+  if (!others.empty())
+    link_ir_files(*M, others);
+  return M;
+}
+
 void translator::check_optimizations_safe(const Module &llvm_module) {
   if (!optEnabled || (optimizeForced && optEnabled))
     return;
@@ -67,8 +213,229 @@ void translator::check_optimizations_safe(const Module &llvm_module) {
       }
 }
 
-bool ll2gb::run_llvm_passes(Module &llvm_module) {
-  translator::check_optimizations_safe(llvm_module);
+static void passes_failed(const string &msg) {
+  errs().changeColor(errs().RED, true);
+  errs() << "error: ";
+  errs().resetColor();
+  errs() << msg << "\n";
+  exit(1);
+}
+
+/// Runs the function passes that populate adds over
+/// every function of M.
+static void run_function_passes(
+    Module &M, function_ref<void(legacy::FunctionPassManager &)> populate) {
+  legacy::FunctionPassManager FPM(&M);
+  populate(FPM);
+  FPM.doInitialization();
+  for (auto &F : M)
+    FPM.run(F);
+  FPM.doFinalization();
+}
+
+/// Returns the compile unit that the global variable
+/// expression GVE belongs to.
+static DICompileUnit *get_unit(const DIGlobalVariableExpression *GVE) {
+  auto *scope = GVE->getVariable()->getScope();
+  while (scope && !isa<DICompileUnit>(scope)) {
+    if (auto *SP = dyn_cast<DISubprogram>(scope))
+      return SP->getUnit();
+    scope = scope->getScope();
+  }
+  return cast_or_null<DICompileUnit>(scope);
+}
+
+/// Every partition went through its own LLVMContext, so the
+/// linked module holds one copy of each compile unit, and of
+/// its global variables, per partition. Maps the copies onto
+/// the first one in place and lists each unit and global
+/// variable once again.
+static void dedupe_compile_units(Module &M) {
+  auto *units = M.getNamedMetadata("llvm.dbg.cu");
+  if (!units)
+    return;
+  ValueToValueMapTy VM;
+  SmallVector<DICompileUnit *, 2> kept;
+  for (auto *N : units->operands()) {
+    auto *CU = cast<DICompileUnit>(N);
+    auto same = find_if(kept, [CU](const DICompileUnit *K) {
+      return K->getFile() == CU->getFile() &&
+             K->getProducer() == CU->getProducer() &&
+             K->getSourceLanguage() == CU->getSourceLanguage();
+    });
+    if (same == kept.end())
+      kept.push_back(CU);
+    else
+      VM.MD()[CU].reset(*same);
+  }
+  if (kept.size() == units->getNumOperands())
+    return;
+
+  SmallVector<pair<unsigned, MDNode *>, 4> MDs;
+  auto remap = [&]() {
+    for (const auto &MD : MDs)
+      MapMetadata(MD.second, VM,
+                  RF_ReuseAndMutateDistinctMDs | RF_IgnoreMissingLocals);
+  };
+  for (auto &GO : M.global_objects()) {
+    GO.getAllMetadata(MDs);
+    remap();
+    if (auto *F = dyn_cast<Function>(&GO))
+      for (auto &BB : *F)
+        for (auto &I : BB) {
+          I.getAllMetadata(MDs);
+          remap();
+        }
+  }
+
+  /// A global is described by the copy from the partition
+  /// that defined it, list that copy in place of the others.
+  auto key = [](const DIGlobalVariable *V) {
+    return make_tuple(V->getName(), V->getLinkageName(), V->getFile(),
+                      V->getLine());
+  };
+  map<DICompileUnit *, SmallVector<Metadata *, 8>> globals;
+  set<decltype(key(nullptr))> described;
+  SmallVector<DIGlobalVariableExpression *, 1> GVEs;
+  for (auto &G : M.globals()) {
+    GVEs.clear();
+    G.getDebugInfo(GVEs);
+    for (auto *GVE : GVEs)
+      if (auto *CU = get_unit(GVE)) {
+        globals[CU].push_back(GVE);
+        described.insert(key(GVE->getVariable()));
+      }
+  }
+  for (auto *CU : kept) {
+    auto &list = globals[CU];
+    for (auto *GVE : CU->getGlobalVariables())
+      if (described.insert(key(GVE->getVariable())).second)
+        list.push_back(GVE);
+    CU->replaceGlobalVariables(MDTuple::get(M.getContext(), list));
+  }
+
+  units->clearOperands();
+  for (auto *CU : kept)
+    units->addOperand(CU);
+}
+
+/// Runs the function passes over M on passThreads threads.
+/// M is split into one partition per thread, every partition
+/// is optimized in its own LLVMContext, and the results are
+/// linked back into a new module in the context of M.
+/// Function passes only look at one function at a time, so
+/// this gives the same result as running them serially.
+static void run_function_passes_parallel(
+    unique_ptr<Module> &M,
+    function<void(legacy::FunctionPassManager &)> populate) {
+  if (passThreads <= 1) {
+    run_function_passes(*M, populate);
+    return;
+  }
+
+  /// SplitModule externalizes local symbols so they can be
+  /// referenced across partitions, and names the unnamed ones
+  /// __llvmsplit_unnamed, remember what to restore.
+  map<const GlobalValue *,
+      pair<GlobalValue::LinkageTypes, GlobalValue::VisibilityTypes>>
+      linkage;
+  for (const auto &GV : M->global_values())
+    linkage[&GV] = {GV.getLinkage(), GV.getVisibility()};
+  SmallPtrSet<const GlobalValue *, 8> unnamed;
+  for (const auto &GV : M->global_values())
+    if (!GV.hasName())
+      unnamed.insert(&GV);
+
+  const auto module_id = M->getModuleIdentifier();
+  vector<SmallString<0>> parts;
+  SplitModule(
+      *M, passThreads,
+      [&](unique_ptr<Module> part) {
+        parts.emplace_back();
+        raw_svector_ostream os(parts.back());
+        WriteBitcodeToFile(*part, os);
+      },
+      false);
+
+  /// Every symbol has a name now, key what is restored by it.
+  map<string, pair<GlobalValue::LinkageTypes, GlobalValue::VisibilityTypes>>
+      named_linkage;
+  for (const auto &entry : linkage)
+    named_linkage[entry.first->getName().str()] = entry.second;
+  vector<string> function_order, global_order, unnamed_names;
+  for (const auto &F : *M)
+    function_order.push_back(F.getName().str());
+  for (const auto &G : M->globals())
+    global_order.push_back(G.getName().str());
+  for (const auto *GV : unnamed)
+    unnamed_names.push_back(GV->getName().str());
+
+  vector<string> errors(parts.size());
+  ThreadPool pool(hardware_concurrency(passThreads));
+  for (size_t i = 0; i < parts.size(); i++)
+    pool.async([&, i] {
+      LLVMContext context;
+      SMDiagnostic err;
+      auto part = parseIR(MemoryBufferRef(parts[i], module_id), err, context);
+      if (!part) {
+        errors[i] = err.getMessage().str();
+        return;
+      }
+      run_function_passes(*part, populate);
+      parts[i].clear();
+      raw_svector_ostream os(parts[i]);
+      WriteBitcodeToFile(*part, os);
+    });
+  pool.wait();
+  for (const auto &error : errors)
+    if (!error.empty())
+      passes_failed(error);
+
+  auto &context = M->getContext();
+  unique_ptr<Module> linked;
+  for (auto &part_bc : parts) {
+    SMDiagnostic err;
+    auto part = parseIR(MemoryBufferRef(part_bc, module_id), err, context);
+    if (!part)
+      passes_failed(err.getMessage().str());
+    if (!linked)
+      linked = std::move(part);
+    else if (Linker::linkModules(*linked, std::move(part)))
+      passes_failed("Unable to link the optimized partitions");
+  }
+
+  for (const auto &entry : named_linkage)
+    if (auto *GV = linked->getNamedValue(entry.first)) {
+      GV->setLinkage(entry.second.first);
+      GV->setVisibility(entry.second.second);
+    }
+  /// Keep the original order, the translation follows it.
+  for (const auto &name : function_order)
+    if (auto *F = linked->getFunction(name))
+      linked->getFunctionList().splice(linked->end(),
+                                       linked->getFunctionList(), F);
+  for (const auto &name : global_order)
+    if (auto *G = linked->getNamedGlobal(name))
+      linked->getGlobalList().splice(linked->global_end(),
+                                     linked->getGlobalList(), G);
+  for (const auto &name : unnamed_names)
+    if (auto *GV = linked->getNamedValue(name))
+      GV->setName("");
+  dedupe_compile_units(*linked);
+  M = std::move(linked);
+}
+
+/// Sets up PM for the -O2 pipeline ll2gb runs.
+static void set_up_builder(PassManagerBuilder &PM) {
+  PM.OptLevel = 2;
+  PM.SizeLevel = 0;
+  PM.LoopVectorize = false;
+  PM.SLPVectorize = false;
+  PM.DisableUnrollLoops = false;
+}
+
+bool ll2gb::run_llvm_passes(unique_ptr<Module> &llvm_module) {
+  translator::check_optimizations_safe(*llvm_module);
   if (verbose) {
     outs().changeColor(raw_ostream::Colors::SAVEDCOLOR, true);
     outs() << "Optimiser ";
@@ -84,41 +451,36 @@ bool ll2gb::run_llvm_passes(Module &llvm_module) {
     }
   }
   if (optEnabled) {
-    legacy::FunctionPassManager FPM(&llvm_module);
+    /// The function passes may run on several threads, so
+    /// each populates its pass manager from its own builder.
+    run_function_passes_parallel(llvm_module,
+                                 [](legacy::FunctionPassManager &FPM) {
+                                   PassManagerBuilder PM;
+                                   set_up_builder(PM);
+                                   PM.populateFunctionPassManager(FPM);
+                                 });
     legacy::PassManager MPM;
     PassManagerBuilder PM;
-    PM.OptLevel = 2;
-    PM.SizeLevel = 0;
-    PM.LoopVectorize = false;
-    PM.SLPVectorize = false;
-    PM.DisableUnrollLoops = false;
+    set_up_builder(PM);
     PM.Inliner = createAlwaysInlinerLegacyPass();
-    PM.populateFunctionPassManager(FPM);
     PM.populateModulePassManager(MPM);
-    FPM.doInitialization();
-    for (auto &F : llvm_module)
-      FPM.run(F);
-    FPM.doFinalization();
-    MPM.run(llvm_module);
+    MPM.run(*llvm_module);
   }
-  legacy::FunctionPassManager FPM(&llvm_module);
-  FPM.add(createDemoteRegisterToMemoryPass());
-
-  FPM.doInitialization();
-  for (auto &F : llvm_module)
-    FPM.run(F);
-  FPM.doFinalization();
+  run_function_passes_parallel(llvm_module,
+                               [](legacy::FunctionPassManager &FPM) {
+                                 FPM.add(createDemoteRegisterToMemoryPass());
+                               });
 
   if (verbose_very && optEnabled) {
     outs().changeColor(outs().BLUE, true);
     outs() << "LLVM IR: ";
     outs().resetColor();
     outs().changeColor(outs().SAVEDCOLOR, true);
-    outs() << llvm_module.getName() << " - Optimized:\n";
+    outs() << llvm_module->getName() << " - Optimized:\n";
     outs().changeColor(outs().YELLOW, true);
     outs() << "------------------------------------------------------\n";
     outs().resetColor();
-    outs() << llvm_module << '\n';
+    outs() << *llvm_module << '\n';
     outs().changeColor(outs().YELLOW, true);
     outs() << "------------------------------------------------------\n";
     outs().resetColor();
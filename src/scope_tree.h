@@ -10,21 +10,31 @@
 
 #include "translator.h"
 
+#include <llvm/Support/Allocator.h>
+
+/// A tree of the debug info scopes of a module, one root per
+/// DISubprogram. It is built once per module and maps each
+/// scope to its qualified name, e.g. main::0::1 for the second
+/// lexical block within the first block of main.
 class ll2gb::translator::scope_tree {
-  struct scope_node;
-  std::map<llvm::DIScope *, scope_node *> scope_scope_node_map;
-  static scope_node root;
-  void populate_names(std::map<llvm::DIScope *, std::string> *, scope_node *);
-  void add_node(llvm::DIScope *);
-  void construct_tree(const llvm::Function &);
+  struct scope_node {
+    llvm::DIScope *scope;
+    scope_node *parent;
+    unsigned num_children = 0;
+    std::string name;           ///< name within the parent scope
+    std::string qualified_name; ///< computed on first use
+    scope_node(llvm::DIScope *scope, scope_node *parent, std::string name)
+        : scope{scope}, parent{parent}, name{std::move(name)} {}
+  };
+  llvm::DenseMap<llvm::DIScope *, scope_node *> scope_scope_node_map;
+  llvm::SpecificBumpPtrAllocator<scope_node>
+      allocator; ///< owns the nodes, freed along with the tree
+  scope_node *add_node(llvm::DIScope *);
+  void construct_tree(const llvm::Module &);
 
 public:
-  scope_tree() {}
-  ~scope_tree() { delete_tree(); }
-  void delete_tree();
-  void
-  get_scope_name_map(const llvm::Function &F,
-                     std::map<llvm::DIScope *, std::string> *scope_name_map);
+  scope_tree(const llvm::Module &M) { construct_tree(M); }
+  const std::string &get_scope_name(llvm::DIScope *);
 };
 
 #endif /* SCOPE_TREE_H */
@@ -0,0 +1,245 @@
+/*
+ * stream_goto.cpp
+ */
+
+#include "ll2gb.h"
+#include "translator.h"
+
+#include <limits>
+#include <sstream>
+
+using namespace std;
+using namespace llvm;
+using namespace ll2gb;
+
+/// The layout below mirrors CBMC's write_goto_binary for
+/// this version of the format.
+static const int streamed_goto_version = 5;
+
+/// Marks an irep that was numbered but not yet written.
+static const size_t unwritten = numeric_limits<size_t>::max();
+
+/// Writes ireps in the layout of irep_serializationt. CBMC's
+/// serializer keeps a copy of every irep it has written, which
+/// would keep the whole program alive, so ireps are instead
+/// shared only within one scope, e.g. one function, and are
+/// released with it. Ids keep counting across scopes since the
+/// reader numbers ireps for the whole file.
+class irep_scope_writert {
+public:
+  irep_scope_writert(irep_serializationt &strings, size_t &next_id)
+      : strings(strings), next_id(next_id) {}
+
+  void reference_convert(const irept &irep, ostream &out) {
+    const size_t number = hashes.number(irep);
+    if (number >= ids.size())
+      ids.resize(number + 1, unwritten);
+    if (ids[number] != unwritten) {
+      write_gb_word(out, ids[number]);
+      return;
+    }
+    ids[number] = next_id++;
+    write_gb_word(out, ids[number]);
+    write_string_ref(out, irep.id());
+    for (const auto &sub : irep.get_sub()) {
+      out.put('S');
+      reference_convert(sub, out);
+    }
+    for (const auto &named_sub : irep.get_named_sub()) {
+      out.put('N');
+      write_string_ref(out, named_sub.first);
+      reference_convert(named_sub.second, out);
+    }
+    out.put(0);
+  }
+
+  /// Strings are few and shared by the whole file.
+  void write_string_ref(ostream &out, const irep_idt &s) {
+    strings.write_string_ref(out, s);
+  }
+
+private:
+  irep_serializationt &strings;
+  size_t &next_id;
+  irep_full_hash_containert hashes;
+  vector<size_t> ids; ///< File wide ids by scope local number.
+};
+
+/// Encodes a symbol the way write_goto_binary does.
+static void write_goto_symbol(ostream &out, irep_scope_writert &irepconverter,
+                              const symbolt &sym) {
+  irepconverter.reference_convert(sym.type, out);
+  irepconverter.reference_convert(sym.value, out);
+  irepconverter.reference_convert(sym.location, out);
+  irepconverter.write_string_ref(out, sym.name);
+  irepconverter.write_string_ref(out, sym.module);
+  irepconverter.write_string_ref(out, sym.base_name);
+  irepconverter.write_string_ref(out, sym.mode);
+  irepconverter.write_string_ref(out, sym.pretty_name);
+  write_gb_word(out, 0); // Used to be the symbol ordering.
+
+  unsigned flags = 0;
+  flags = (flags << 1) | static_cast<int>(sym.is_weak);
+  flags = (flags << 1) | static_cast<int>(sym.is_type);
+  flags = (flags << 1) | static_cast<int>(sym.is_property);
+  flags = (flags << 1) | static_cast<int>(sym.is_macro);
+  flags = (flags << 1) | static_cast<int>(sym.is_exported);
+  flags = (flags << 1) | static_cast<int>(sym.is_input);
+  flags = (flags << 1) | static_cast<int>(sym.is_output);
+  flags = (flags << 1) | static_cast<int>(sym.is_state_var);
+  flags = (flags << 1) | static_cast<int>(sym.is_parameter);
+  flags = (flags << 1) | static_cast<int>(sym.is_auxiliary);
+  flags = (flags << 1) | static_cast<int>(false); // Used to be the binding.
+  flags = (flags << 1) | static_cast<int>(sym.is_lvalue);
+  flags = (flags << 1) | static_cast<int>(sym.is_static_lifetime);
+  flags = (flags << 1) | static_cast<int>(sym.is_thread_local);
+  flags = (flags << 1) | static_cast<int>(sym.is_file_local);
+  flags = (flags << 1) | static_cast<int>(sym.is_extern);
+  flags = (flags << 1) | static_cast<int>(sym.is_volatile);
+  write_gb_word(out, flags);
+}
+
+/// Encodes a function body the way write_goto_binary does.
+static void write_goto_function(ostream &out,
+                                irep_scope_writert &irepconverter,
+                                const irep_idt &name,
+                                const goto_programt &body) {
+  write_gb_string(out, id2string(name));
+  write_gb_word(out, body.instructions.size());
+  for (const auto &instruction : body.instructions) {
+    irepconverter.reference_convert(instruction.get_code(), out);
+    irepconverter.reference_convert(instruction.source_location(), out);
+    write_gb_word(out, (long)instruction.type());
+    const exprt condition = instruction.has_condition()
+                                ? instruction.get_condition()
+                                : true_exprt();
+    irepconverter.reference_convert(condition, out);
+    write_gb_word(out, instruction.target_number);
+    write_gb_word(out, instruction.targets.size());
+    for (const auto &target : instruction.targets)
+      write_gb_word(out, target->target_number);
+    write_gb_word(out, instruction.labels.size());
+    for (const auto &label : instruction.labels)
+      irepconverter.write_string_ref(out, label);
+  }
+}
+
+/// Encodes a function as a self contained GOTO binary
+/// holding just that function and its symbol.
+string translator::encode_function(const irep_idt &name,
+                                   goto_programt &body) {
+  symbol_tablet chunk_symbols;
+  symbolt symbol = symbol_table.lookup_ref(name);
+  // The chunk holds the body, the symbol value need not repeat it.
+  if (symbol.value.is_not_nil())
+    symbol.value = code_blockt();
+  chunk_symbols.add(symbol);
+  goto_functionst chunk_functions;
+  auto &chunk_body = chunk_functions.function_map[name].body;
+  chunk_body.swap(body);
+  chunk_body.update();
+
+  stringstream chunk;
+  write_goto_binary(chunk, chunk_symbols, chunk_functions);
+  body.swap(chunk_body);
+  return chunk.str();
+}
+
+/// Serializes a translated function to the spool file and
+/// releases its body.
+void translator::spool_function(const irep_idt &name) {
+  if (!spool_file) {
+    spool_file = tmpfile();
+    if (!spool_file) {
+      error_state = "Unable to create spool file for streamed output";
+      return;
+    }
+  }
+  auto function = goto_functions.function_map.find(name);
+  const auto data = encode_function(name, function->second.body);
+  goto_functions.function_map.erase(function);
+  if (fwrite(data.data(), 1, data.size(), spool_file) != data.size()) {
+    error_state = "Unable to write function to spool file: " + id2string(name);
+    return;
+  }
+  spooled_functions.emplace_back(name, data.size());
+}
+
+/// Reads the next chunk from the spool file into data.
+/// Chunks are read back in the order they were spooled.
+bool translator::read_spooled_function(
+    const pair<irep_idt, size_t> &spooled, string &data) {
+  data.resize(spooled.second);
+  if (fread(&data[0], 1, data.size(), spool_file) != data.size()) {
+    error_state = "Unable to read function back from spool file: " +
+                  id2string(spooled.first);
+    return true;
+  }
+  return false;
+}
+
+/// Writes the GOTO binary when functions were spooled during
+/// translation. The symbol table is written first, followed by
+/// the functions still in memory. The spooled functions are
+/// then decoded and written one at a time, so at most one of
+/// their bodies is in memory at once.
+bool translator::write_goto_streamed(ostream &out) {
+  if (GOTO_BINARY_VERSION != streamed_goto_version) {
+    error_state = "Streamed output does not support GOTO binary version " +
+                  to_string(GOTO_BINARY_VERSION);
+    return true;
+  }
+  llvm_module.reset();
+  out << char(0x7f) << "GBF";
+  write_gb_word(out, GOTO_BINARY_VERSION);
+
+  irep_serializationt::ireps_containert strings;
+  irep_serializationt string_writer(strings);
+  size_t next_id = 0;
+
+  {
+    irep_scope_writert irepconverter(string_writer, next_id);
+    write_gb_word(out, symbol_table.symbols.size());
+    for (const auto &symbol : symbol_table.symbols)
+      write_goto_symbol(out, irepconverter, symbol.second);
+  }
+
+  size_t count = spooled_functions.size();
+  for (const auto &function : goto_functions.function_map)
+    if (function.second.body_available())
+      count++;
+  write_gb_word(out, count);
+
+  // Functions that never left memory, e.g. the entry point.
+  goto_functions.update();
+  for (const auto &function : goto_functions.function_map) {
+    if (!function.second.body_available())
+      continue;
+    irep_scope_writert irepconverter(string_writer, next_id);
+    write_goto_function(out, irepconverter, function.first,
+                        function.second.body);
+  }
+
+  if (spool_file)
+    rewind(spool_file);
+  string data;
+  for (const auto &spooled : spooled_functions) {
+    if (read_spooled_function(spooled, data))
+      return true;
+    istringstream chunk(data);
+    symbol_tablet chunk_symbols;
+    goto_functionst chunk_functions;
+    if (read_bin_goto_object(chunk, id2string(spooled.first), chunk_symbols,
+                             chunk_functions, msg_handler)) {
+      error_state = "Unable to decode spooled function: " +
+                    id2string(spooled.first);
+      return true;
+    }
+    auto &body = chunk_functions.function_map.at(spooled.first).body;
+    body.update();
+    irep_scope_writert irepconverter(string_writer, next_id);
+    write_goto_function(out, irepconverter, spooled.first, body);
+  }
+  spooled_functions.clear();
+  return !out.good();
+}
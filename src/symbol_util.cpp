@@ -136,6 +136,13 @@ typet translator::symbol_util::get_goto_type(const Type *ll_type) {
     type = array_typet(get_goto_type(ll_type->getArrayElementType()), arr_len);
     break;
   }
+  case Type::FixedVectorTyID: {
+    auto ll_vec_type = cast<FixedVectorType>(ll_type);
+    auto vec_len = from_integer(ll_vec_type->getNumElements(), index_type());
+    type = vector_typet(index_type(),
+                        get_goto_type(ll_vec_type->getElementType()), vec_len);
+    break;
+  }
   case Type::PointerTyID: {
     type = pointer_type(get_goto_type(ll_type->getPointerElementType()));
     break;
@@ -18,7 +18,6 @@ using namespace ll2gb;
 symbol_tablet translator::symbol_table = symbol_tablet();
 map<const Argument *, string> translator::func_arg_name_map =
     map<const Argument *, string>();
-map<DIScope *, string> translator::scope_name_map = map<DIScope *, string>();
 string translator::error_state = "";
 map<translator::intrinsics, bool> translator::intrinsic_support_added =
     map<intrinsics, bool>();
@@ -39,6 +38,19 @@ source_locationt translator::get_location(const Instruction &I) {
   return location;
 }
 
+/// If DebugInfo is present then return the location
+/// of the definition of F.
+source_locationt translator::get_location(const Function &F) {
+  source_locationt location;
+  if (const auto *SP = F.getSubprogram()) {
+    location.set_file(SP->getFilename().str());
+    location.set_working_directory(SP->getDirectory().str());
+    location.set_line(SP->getLine());
+    location.set_function(F.getName().str());
+  }
+  return location;
+}
+
 /// Translates and returns expressions for constant values.
 exprt translator::get_expr_const(const Constant &C) {
   exprt expr;
@@ -79,38 +91,44 @@ exprt translator::get_expr_const(const Constant &C) {
         expr = struct_exprt(expr_opnds, type);
       }
     } else if (isa<ConstantVector>(C)) {
+      const auto &CV = cast<ConstantVector>(C);
+      exprt::operandst operands;
+      for (unsigned i = 0; i < CV.getNumOperands(); i++)
+        operands.push_back(get_expr(*CV.getAggregateElement(i)));
+      expr = vector_exprt(
+          operands, to_vector_type(symbol_util::get_goto_type(C.getType())));
     }
   } else if (isa<ConstantData>(C)) {
     if (isa<ConstantAggregateZero>(C)) {
-      const auto &CAZ = cast<ConstantAggregateZero>(C);
-      exprt::operandst list_operands;
-      for (unsigned i = 0; i < CAZ.getNumElements(); i++) {
-        const auto &V = CAZ.getAggregateElement(i);
-        list_operands.push_back(get_expr(*V));
-      }
-      if (C.getType()->isArrayTy())
-        expr =
-            array_exprt(list_operands,
-                        to_array_type(symbol_util::get_goto_type(C.getType())));
+      /// CBMC's zero initializer uses array_of for arrays, keeping
+      /// the expr the same size whatever the number of elements.
+      auto zero =
+          zero_initializer(symbol_util::get_goto_type(C.getType()),
+                           source_locationt(), namespacet(symbol_table));
+      if (zero)
+        expr = *zero;
       else {
-        auto type = symbol_util::get_goto_type(C.getType());
-        expr = struct_exprt(list_operands, type);
+        const auto &CAZ = cast<ConstantAggregateZero>(C);
+        exprt::operandst list_operands;
+        for (unsigned i = 0; i < CAZ.getNumElements(); i++) {
+          const auto &V = CAZ.getAggregateElement(i);
+          list_operands.push_back(get_expr(*V));
+        }
+        if (C.getType()->isArrayTy())
+          expr = array_exprt(
+              list_operands,
+              to_array_type(symbol_util::get_goto_type(C.getType())));
+        else if (C.getType()->isVectorTy())
+          expr = vector_exprt(
+              list_operands,
+              to_vector_type(symbol_util::get_goto_type(C.getType())));
+        else {
+          auto type = symbol_util::get_goto_type(C.getType());
+          expr = struct_exprt(list_operands, type);
+        }
       }
     } else if (isa<ConstantDataSequential>(C)) {
-      const auto &CDS = cast<ConstantDataSequential>(C);
-      exprt list_expr;
-      exprt::operandst operands;
-      for (unsigned i = 0; i < CDS.getNumElements(); i++) {
-        const auto &V = CDS.getAggregateElement(i);
-        operands.emplace_back(get_expr(*V));
-      }
-      if (C.getType()->isArrayTy())
-        list_expr = array_exprt(
-            operands, to_array_type(symbol_util::get_goto_type(C.getType())));
-      else
-        list_expr = struct_exprt(
-            operands, to_struct_type(symbol_util::get_goto_type(C.getType())));
-      expr = list_expr;
+      expr = get_expr_const_data(cast<ConstantDataSequential>(C));
     } else if (isa<ConstantFP>(C)) {
       auto &CF = cast<ConstantFP>(C);
       floatbv_typet type;
@@ -186,18 +204,9 @@ exprt translator::get_expr_const(const Constant &C) {
           to_pointer_type(symbol_util::get_goto_type(C.getType())));
     } else if (isa<ConstantTokenNone>(C)) {
     } else if (isa<UndefValue>(C)) {
-      auto symbol = symbol_util::create_symbol(C.getType());
-      if (C.hasName()) {
-        symbol.base_name = C.getName().str();
-        symbol.name = string("ll2gb_undef_") + symbol.base_name.c_str();
-      } else
-        symbol.name = string("ll2gb_undef_") + symbol.name.c_str();
-      if (symbol_table.add(symbol)) {
-        error_state = "duplicate symbol names encountered!";
-      }
-      goto_program.add(goto_programt::make_decl(symbol.symbol_expr()));
-      goto_program.update();
-      expr = symbol.symbol_expr();
+      /// Every use is free to see any value, so no symbol is needed.
+      expr = side_effect_expr_nondett(symbol_util::get_goto_type(C.getType()),
+                                      source_locationt());
     }
   } else if (isa<ConstantExpr>(C)) {
     auto CI = &cast<ConstantExpr>(C);
@@ -211,14 +220,90 @@ exprt translator::get_expr_const(const Constant &C) {
   return expr;
 }
 
-/// Translates and returns a float comparission expr.
-exprt translator::get_expr_fcmp(const FCmpInst &FCI) {
+/// The most elements a table may update on top of its
+/// array_of. Every update nests one more with expr.
+static const unsigned max_const_data_updates = 64;
+
+/// Translates a ConstantDataSequential, i.e. a string or a
+/// table of numbers. C strings become a string constant, and
+/// tables that are mostly one value an array_of, updated at
+/// the other indices. LLVM uniques these constants, so each
+/// table is translated once and the expr shared by its uses.
+exprt translator::get_expr_const_data(const ConstantDataSequential &CDS) {
+  auto cached = const_data_map.find(&CDS);
+  if (cached != const_data_map.end())
+    return cached->second;
+
   exprt expr;
-  const auto &ll_op1 = FCI.getOperand(0);
-  const auto &ll_op2 = FCI.getOperand(1);
-  auto expr_op1 = get_expr(*ll_op1);
-  auto expr_op2 = get_expr(*ll_op2);
-  switch (FCI.getPredicate()) {
+  const auto type = symbol_util::get_goto_type(CDS.getType());
+  const unsigned n = CDS.getNumElements();
+  const Constant *dominant = nullptr;
+  unsigned dominant_count = 0;
+  if (type.id() == ID_array && !CDS.isCString()) {
+    DenseMap<const Constant *, unsigned> counts;
+    for (unsigned i = 0; i < n; i++) {
+      const auto *E = CDS.getElementAsConstant(i);
+      if (++counts[E] > dominant_count) {
+        dominant = E;
+        dominant_count = counts[E];
+      }
+    }
+  }
+
+  if (type.id() == ID_array && CDS.isCString()) {
+    string_constantt str(CDS.getAsCString());
+    str.type() = type;
+    expr = str;
+  } else if (dominant && 2 * (n - dominant_count) < n &&
+             n - dominant_count <= max_const_data_updates) {
+    /// Each with expr updates a single index, so they are
+    /// nested, one per element that differs.
+    expr = array_of_exprt(get_expr(*dominant), to_array_type(type));
+    for (unsigned i = 0; i < n; i++) {
+      const auto *E = CDS.getElementAsConstant(i);
+      if (E != dominant)
+        expr = with_exprt(expr, from_integer(i, index_type()), get_expr(*E));
+    }
+  } else {
+    exprt::operandst operands;
+    for (unsigned i = 0; i < n; i++)
+      operands.emplace_back(get_expr(*CDS.getElementAsConstant(i)));
+    if (type.id() == ID_array)
+      expr = array_exprt(operands, to_array_type(type));
+    else
+      expr = vector_exprt(operands, to_vector_type(type));
+  }
+  const_data_map[&CDS] = expr;
+  return expr;
+}
+
+/// Applies f to ops and returns the result of type. For
+/// a vector type f is applied lane by lane, vector operands
+/// being indexed and scalar ones shared by every lane. This
+/// is used for the operations CBMC has no vector form of.
+static exprt lane_wise(const typet &type, const exprt::operandst &ops,
+                       function_ref<exprt(const exprt::operandst &)> f) {
+  if (type.id() != ID_vector)
+    return f(ops);
+  const auto &vec_type = to_vector_type(type);
+  const auto lanes = numeric_cast_v<size_t>(vec_type.size());
+  exprt::operandst lane_exprs, lane_ops(ops.size());
+  for (size_t i = 0; i < lanes; i++) {
+    const auto index_expr = from_integer(i, index_type());
+    for (size_t j = 0; j < ops.size(); j++)
+      lane_ops[j] = ops[j].type().id() == ID_vector
+                        ? index_exprt(ops[j], index_expr)
+                        : ops[j];
+    lane_exprs.push_back(f(lane_ops));
+  }
+  return vector_exprt(lane_exprs, vec_type);
+}
+
+/// Builds the float comparison pred of expr_op1 and expr_op2.
+static exprt fcmp_expr(CmpInst::Predicate pred, const exprt &expr_op1,
+                       const exprt &expr_op2) {
+  exprt expr;
+  switch (pred) {
   case CmpInst::Predicate::FCMP_FALSE: {
     expr = false_exprt();
     break;
@@ -347,19 +432,27 @@ exprt translator::get_expr_fcmp(const FCmpInst &FCI) {
     break;
   }
   default:
-    error_state = "Unknown FCmp Instr Predicate";
+    translator::error_state = "Unknown FCmp Instr Predicate";
   }
   return expr;
 }
 
-/// Translates and returns an int comparission expr.
-exprt translator::get_expr_icmp(const ICmpInst &ICI) {
+/// Translates and returns a float comparission expr.
+exprt translator::get_expr_fcmp(const FCmpInst &FCI) {
+  const auto pred = FCI.getPredicate();
+  return lane_wise(symbol_util::get_goto_type(FCI.getType()),
+                   {get_expr(*FCI.getOperand(0)), get_expr(*FCI.getOperand(1))},
+                   [pred](const exprt::operandst &ops) {
+                     return fcmp_expr(pred, ops[0], ops[1]);
+                   });
+}
+
+/// Builds the int comparison pred of expr_op1 and expr_op2,
+/// both of them width bits wide.
+static exprt icmp_expr(CmpInst::Predicate pred, exprt expr_op1, exprt expr_op2,
+                       unsigned width) {
   exprt expr;
-  const auto &ll_op1 = ICI.getOperand(0);
-  const auto &ll_op2 = ICI.getOperand(1);
-  auto expr_op1 = get_expr(*ll_op1);
-  auto expr_op2 = get_expr(*ll_op2);
-  switch (ICI.getPredicate()) {
+  switch (pred) {
   case CmpInst::Predicate::ICMP_EQ: {
     expr = equal_exprt(expr_op1, expr_op2);
     break;
@@ -386,74 +479,69 @@ exprt translator::get_expr_icmp(const ICmpInst &ICI) {
   }
   case CmpInst::Predicate::ICMP_UGE: { // TODO:Check if its correct to cast to
                                        // unsigned like this
-    expr_op1 = typecast_exprt::conditional_cast(
-        expr_op1,
-        unsignedbv_typet(ll_op1->getType()->isPointerTy()
-                             ? 64
-                             : ll_op1->getType()->getIntegerBitWidth()));
-    expr_op2 = typecast_exprt::conditional_cast(
-        expr_op2,
-        unsignedbv_typet(ll_op2->getType()->isPointerTy()
-                             ? 64
-                             : ll_op2->getType()->getIntegerBitWidth()));
+    expr_op1 =
+        typecast_exprt::conditional_cast(expr_op1, unsignedbv_typet(width));
+    expr_op2 =
+        typecast_exprt::conditional_cast(expr_op2, unsignedbv_typet(width));
     expr = binary_relation_exprt(expr_op1, ID_ge, expr_op2);
     break;
   }
   case CmpInst::Predicate::ICMP_UGT: {
-    expr_op1 = typecast_exprt::conditional_cast(
-        expr_op1,
-        unsignedbv_typet(ll_op1->getType()->isPointerTy()
-                             ? 64
-                             : ll_op1->getType()->getIntegerBitWidth()));
-    expr_op2 = typecast_exprt::conditional_cast(
-        expr_op2,
-        unsignedbv_typet(ll_op2->getType()->isPointerTy()
-                             ? 64
-                             : ll_op2->getType()->getIntegerBitWidth()));
+    expr_op1 =
+        typecast_exprt::conditional_cast(expr_op1, unsignedbv_typet(width));
+    expr_op2 =
+        typecast_exprt::conditional_cast(expr_op2, unsignedbv_typet(width));
     expr = binary_relation_exprt(expr_op1, ID_gt, expr_op2);
     break;
   }
   case CmpInst::Predicate::ICMP_ULE: {
-    expr_op1 = typecast_exprt::conditional_cast(
-        expr_op1,
-        unsignedbv_typet(ll_op1->getType()->isPointerTy()
-                             ? 64
-                             : ll_op1->getType()->getIntegerBitWidth()));
-    expr_op2 = typecast_exprt::conditional_cast(
-        expr_op2,
-        unsignedbv_typet(ll_op2->getType()->isPointerTy()
-                             ? 64
-                             : ll_op2->getType()->getIntegerBitWidth()));
+    expr_op1 =
+        typecast_exprt::conditional_cast(expr_op1, unsignedbv_typet(width));
+    expr_op2 =
+        typecast_exprt::conditional_cast(expr_op2, unsignedbv_typet(width));
     expr = binary_relation_exprt(expr_op1, ID_le, expr_op2);
     break;
   }
   case CmpInst::Predicate::ICMP_ULT: {
-    expr_op1 = typecast_exprt::conditional_cast(
-        expr_op1,
-        unsignedbv_typet(ll_op1->getType()->isPointerTy()
-                             ? 64
-                             : ll_op1->getType()->getIntegerBitWidth()));
-    expr_op2 = typecast_exprt::conditional_cast(
-        expr_op2,
-        unsignedbv_typet(ll_op2->getType()->isPointerTy()
-                             ? 64
-                             : ll_op2->getType()->getIntegerBitWidth()));
+    expr_op1 =
+        typecast_exprt::conditional_cast(expr_op1, unsignedbv_typet(width));
+    expr_op2 =
+        typecast_exprt::conditional_cast(expr_op2, unsignedbv_typet(width));
     expr = binary_relation_exprt(expr_op1, ID_lt, expr_op2);
     break;
   }
   default:
-    error_state = "Unknown ICmp Instr Predicate";
+    translator::error_state = "Unknown ICmp Instr Predicate";
   }
   return expr;
 }
 
+/// Translates and returns an int comparission expr.
+exprt translator::get_expr_icmp(const ICmpInst &ICI) {
+  const auto &ll_op1 = ICI.getOperand(0);
+  const auto &ll_op2 = ICI.getOperand(1);
+  const auto pred = ICI.getPredicate();
+  const auto ll_type = ll_op1->getType()->getScalarType();
+  const unsigned width =
+      ll_type->isPointerTy() ? 64 : ll_type->getIntegerBitWidth();
+  return lane_wise(symbol_util::get_goto_type(ICI.getType()),
+                   {get_expr(*ll_op1), get_expr(*ll_op2)},
+                   [pred, width](const exprt::operandst &ops) {
+                     return icmp_expr(pred, ops[0], ops[1], width);
+                   });
+}
+
 /// Performs typcasting to truncate an expr and returns it.
 exprt translator::get_expr_trunc(const TruncInst &TI) {
   exprt expr;
   const auto &ll_op1 = TI.getOperand(0);
   const auto &ll_op2 = TI.getDestTy();
   auto expr_op1 = get_expr(*ll_op1);
-  expr = typecast_exprt(expr_op1, symbol_util::get_goto_type(ll_op2));
+  const auto lane_type = symbol_util::get_goto_type(ll_op2->getScalarType());
+  expr = lane_wise(symbol_util::get_goto_type(ll_op2), {expr_op1},
+                   [&lane_type](const exprt::operandst &ops) -> exprt {
+                     return typecast_exprt(ops[0], lane_type);
+                   });
   return expr;
 }
 
@@ -514,7 +602,10 @@ exprt translator::get_expr_mul(const Instruction &MI) {
   const auto &ll_op2 = MI.getOperand(1);
   auto expr_op1 = get_expr(*ll_op1);
   auto expr_op2 = get_expr(*ll_op2);
-  expr = mult_exprt(expr_op1, expr_op2);
+  expr = lane_wise(expr_op1.type(), {expr_op1, expr_op2},
+                   [](const exprt::operandst &ops) -> exprt {
+                     return mult_exprt(ops[0], ops[1]);
+                   });
   return expr;
 }
 
@@ -539,7 +630,10 @@ exprt translator::get_expr_sdiv(const Instruction &SDI) {
   const auto &ll_op2 = SDI.getOperand(1);
   auto expr_op1 = get_expr(*ll_op1);
   auto expr_op2 = get_expr(*ll_op2);
-  expr = div_exprt(expr_op1, expr_op2);
+  expr = lane_wise(expr_op1.type(), {expr_op1, expr_op2},
+                   [](const exprt::operandst &ops) -> exprt {
+                     return div_exprt(ops[0], ops[1]);
+                   });
   return expr;
 }
 
@@ -550,7 +644,10 @@ exprt translator::get_expr_srem(const Instruction &SRI) {
   const auto &ll_op2 = SRI.getOperand(1);
   auto expr_op1 = get_expr(*ll_op1);
   auto expr_op2 = get_expr(*ll_op2);
-  expr = mod_exprt(expr_op1, expr_op2);
+  expr = lane_wise(expr_op1.type(), {expr_op1, expr_op2},
+                   [](const exprt::operandst &ops) -> exprt {
+                     return mod_exprt(ops[0], ops[1]);
+                   });
   return expr;
 }
 
@@ -572,25 +669,22 @@ exprt translator::get_expr_fdiv(const Instruction &FDI) {
 /// to unsigned, perform the div, and then again
 /// typecast back to signed.
 exprt translator::get_expr_udiv(const Instruction &UDI) {
-  exprt expr;
   const auto &ll_op1 = UDI.getOperand(0);
   const auto &ll_op2 = UDI.getOperand(1);
-  auto expr_op1 = get_expr(*ll_op1);
-  auto expr_op2 = get_expr(*ll_op2);
-  expr_op1 = typecast_exprt::conditional_cast(
-      expr_op1,
-      unsignedbv_typet(ll_op1->getType()->isPointerTy()
-                           ? 64
-                           : ll_op1->getType()->getIntegerBitWidth()));
-  expr_op2 = typecast_exprt::conditional_cast(
-      expr_op2,
-      unsignedbv_typet(ll_op2->getType()->isPointerTy()
-                           ? 64
-                           : ll_op2->getType()->getIntegerBitWidth()));
-  expr = div_exprt(expr_op1, expr_op2);
-  expr = typecast_exprt::conditional_cast(
-      expr, signedbv_typet(ll_op1->getType()->getIntegerBitWidth()));
-  return expr;
+  const auto ll_type = ll_op1->getType()->getScalarType();
+  const unsigned width =
+      ll_type->isPointerTy() ? 64 : ll_type->getIntegerBitWidth();
+  return lane_wise(
+      symbol_util::get_goto_type(UDI.getType()),
+      {get_expr(*ll_op1), get_expr(*ll_op2)},
+      [width](const exprt::operandst &ops) {
+        auto expr_op1 =
+            typecast_exprt::conditional_cast(ops[0], unsignedbv_typet(width));
+        auto expr_op2 =
+            typecast_exprt::conditional_cast(ops[1], unsignedbv_typet(width));
+        return typecast_exprt::conditional_cast(div_exprt(expr_op1, expr_op2),
+                                                signedbv_typet(width));
+      });
 }
 
 /// Translates and returns a rem expr. Since it is
@@ -598,25 +692,22 @@ exprt translator::get_expr_udiv(const Instruction &UDI) {
 /// to unsigned, perform the rem, and then again
 /// typecast back to signed.
 exprt translator::get_expr_urem(const Instruction &URI) {
-  exprt expr;
   const auto &ll_op1 = URI.getOperand(0);
   const auto &ll_op2 = URI.getOperand(1);
-  auto expr_op1 = get_expr(*ll_op1);
-  auto expr_op2 = get_expr(*ll_op2);
-  expr_op1 = typecast_exprt::conditional_cast(
-      expr_op1,
-      unsignedbv_typet(ll_op1->getType()->isPointerTy()
-                           ? 64
-                           : ll_op1->getType()->getIntegerBitWidth()));
-  expr_op2 = typecast_exprt::conditional_cast(
-      expr_op2,
-      unsignedbv_typet(ll_op2->getType()->isPointerTy()
-                           ? 64
-                           : ll_op2->getType()->getIntegerBitWidth()));
-  expr = mod_exprt(expr_op1, expr_op2);
-  expr = typecast_exprt::conditional_cast(
-      expr, signedbv_typet(ll_op1->getType()->getIntegerBitWidth()));
-  return expr;
+  const auto ll_type = ll_op1->getType()->getScalarType();
+  const unsigned width =
+      ll_type->isPointerTy() ? 64 : ll_type->getIntegerBitWidth();
+  return lane_wise(
+      symbol_util::get_goto_type(URI.getType()),
+      {get_expr(*ll_op1), get_expr(*ll_op2)},
+      [width](const exprt::operandst &ops) {
+        auto expr_op1 =
+            typecast_exprt::conditional_cast(ops[0], unsignedbv_typet(width));
+        auto expr_op2 =
+            typecast_exprt::conditional_cast(ops[1], unsignedbv_typet(width));
+        return typecast_exprt::conditional_cast(mod_exprt(expr_op1, expr_op2),
+                                                signedbv_typet(width));
+      });
 }
 
 /// Translates ANDInstr.
@@ -674,7 +765,10 @@ exprt translator::get_expr_shl(const Instruction &SLI) {
   const auto &ll_op2 = SLI.getOperand(1);
   auto expr_op1 = get_expr(*ll_op1);
   auto expr_op2 = get_expr(*ll_op2);
-  expr = shl_exprt(expr_op1, expr_op2);
+  expr = lane_wise(expr_op1.type(), {expr_op1, expr_op2},
+                   [](const exprt::operandst &ops) -> exprt {
+                     return shl_exprt(ops[0], ops[1]);
+                   });
   return expr;
 }
 
@@ -686,7 +780,10 @@ exprt translator::get_expr_lshr(const Instruction &LSRI) {
   const auto &ll_op2 = LSRI.getOperand(1);
   auto expr_op1 = get_expr(*ll_op1);
   auto expr_op2 = get_expr(*ll_op2);
-  expr = lshr_exprt(expr_op1, expr_op2);
+  expr = lane_wise(expr_op1.type(), {expr_op1, expr_op2},
+                   [](const exprt::operandst &ops) -> exprt {
+                     return lshr_exprt(ops[0], ops[1]);
+                   });
   return expr;
 }
 
@@ -698,7 +795,10 @@ exprt translator::get_expr_ashr(const Instruction &ASRI) {
   const auto &ll_op2 = ASRI.getOperand(1);
   auto expr_op1 = get_expr(*ll_op1);
   auto expr_op2 = get_expr(*ll_op2);
-  expr = ashr_exprt(expr_op1, expr_op2);
+  expr = lane_wise(expr_op1.type(), {expr_op1, expr_op2},
+                   [](const exprt::operandst &ops) -> exprt {
+                     return ashr_exprt(ops[0], ops[1]);
+                   });
   return expr;
 }
 
@@ -706,7 +806,9 @@ exprt translator::get_expr_ashr(const Instruction &ASRI) {
 ///	typecasting the address of the value,
 ///	followed by a derefernce.
 ///	Intuition:	(float)a != *(float*)&a
-///	Here we want the latter.
+///	Here we want the latter. Casts from or to a vector,
+///	whose value need not live in memory, reinterpret the
+///	bytes of the value instead.
 exprt translator::get_expr_bitcast(const BitCastInst &BI) {
   exprt expr;
   const auto &ll_op1 = BI.getOperand(0);
@@ -714,6 +816,10 @@ exprt translator::get_expr_bitcast(const BitCastInst &BI) {
   expr = get_expr(*ll_op1);
   if (expr.type().id() == ID_pointer || expr.type().id() == ID_array)
     expr = typecast_exprt(expr, symbol_util::get_goto_type(ll_op2));
+  else if (ll_op1->getType()->isVectorTy() || ll_op2->isVectorTy())
+    expr = byte_extract_exprt(byte_extract_id(), expr,
+                              from_integer(0, index_type()),
+                              symbol_util::get_goto_type(ll_op2));
   else {
     expr = get_expr(*ll_op1, true);
     expr = address_of_exprt(expr);
@@ -727,95 +833,100 @@ exprt translator::get_expr_bitcast(const BitCastInst &BI) {
 /// Translates FPExtInst. By doing
 ///	a floatbv_typecast on it.
 exprt translator::get_expr_fpext(const FPExtInst &FPEI) {
-  exprt expr;
   const auto &ll_op1 = FPEI.getOperand(0);
   const auto &ll_op2 = FPEI.getDestTy();
-  expr = get_expr(*ll_op1);
+  const auto lane_type = symbol_util::get_goto_type(ll_op2->getScalarType());
   auto rounding_mode =
       symbol_table.lookup("__CPROVER_rounding_mode")->symbol_expr();
-  expr = floatbv_typecast_exprt(expr, rounding_mode,
-                                symbol_util::get_goto_type(ll_op2));
-  return expr;
+  return lane_wise(symbol_util::get_goto_type(ll_op2), {get_expr(*ll_op1)},
+                   [&](const exprt::operandst &ops) -> exprt {
+                     return floatbv_typecast_exprt(ops[0], rounding_mode,
+                                                   lane_type);
+                   });
 }
 
 /// Translates FPToSIInst. By doing
 ///	a floatbv_typecast on it.
 exprt translator::get_expr_fptosi(const FPToSIInst &FPTSI) {
-  exprt expr;
   const auto &ll_op1 = FPTSI.getOperand(0);
   const auto &ll_op2 = FPTSI.getDestTy();
-  expr = get_expr(*ll_op1);
+  const auto lane_type = symbol_util::get_goto_type(ll_op2->getScalarType());
   auto rounding_mode =
       from_integer(ieee_floatt::ROUND_TO_ZERO, signed_int_type());
-  expr = floatbv_typecast_exprt(expr, rounding_mode,
-                                symbol_util::get_goto_type(ll_op2));
-  return expr;
+  return lane_wise(symbol_util::get_goto_type(ll_op2), {get_expr(*ll_op1)},
+                   [&](const exprt::operandst &ops) -> exprt {
+                     return floatbv_typecast_exprt(ops[0], rounding_mode,
+                                                   lane_type);
+                   });
 }
 
 /// Translates SIToFPInst. By doing
 ///	a floatbv_typecast on it.
 exprt translator::get_expr_sitofp(const SIToFPInst &SITFP) {
-  exprt expr;
   const auto &ll_op1 = SITFP.getOperand(0);
   const auto &ll_op2 = SITFP.getDestTy();
-  expr = get_expr(*ll_op1);
-  if (expr.type().id() == ID_bool)
-    expr = typecast_exprt(expr, signedbv_typet(32));
+  const auto lane_type = symbol_util::get_goto_type(ll_op2->getScalarType());
   auto rounding_mode =
       symbol_table.lookup("__CPROVER_rounding_mode")->symbol_expr();
-  if (expr.type().id() == ID_bool)
-    expr = typecast_exprt(expr, signedbv_typet(32));
-  expr = floatbv_typecast_exprt(expr, rounding_mode,
-                                symbol_util::get_goto_type(ll_op2));
-  return expr;
+  return lane_wise(symbol_util::get_goto_type(ll_op2), {get_expr(*ll_op1)},
+                   [&](const exprt::operandst &ops) -> exprt {
+                     auto expr = ops[0];
+                     if (expr.type().id() == ID_bool)
+                       expr = typecast_exprt(expr, signedbv_typet(32));
+                     return floatbv_typecast_exprt(expr, rounding_mode,
+                                                   lane_type);
+                   });
 }
 
 /// Translates FPToUIInst. By doing
 ///	a floatbv_typecast on it.
 exprt translator::get_expr_fptoui(const FPToUIInst &FPTUI) {
-  exprt expr;
   const auto &ll_op1 = FPTUI.getOperand(0);
   const auto &ll_op2 = FPTUI.getDestTy();
-  expr = get_expr(*ll_op1);
+  const auto lane_type = symbol_util::get_goto_type(ll_op2->getScalarType());
+  const auto width = ll_op2->getScalarSizeInBits();
   auto rounding_mode =
       from_integer(ieee_floatt::ROUND_TO_ZERO, signed_int_type());
-  expr = typecast_exprt(
-      floatbv_typecast_exprt(expr, rounding_mode,
-                             unsignedbv_typet(ll_op2->getIntegerBitWidth())),
-      symbol_util::get_goto_type(ll_op2));
-  return expr;
+  return lane_wise(symbol_util::get_goto_type(ll_op2), {get_expr(*ll_op1)},
+                   [&](const exprt::operandst &ops) -> exprt {
+                     return typecast_exprt(
+                         floatbv_typecast_exprt(ops[0], rounding_mode,
+                                                unsignedbv_typet(width)),
+                         lane_type);
+                   });
 }
 
 /// Translates UIToFPInst. By doing
 ///	a floatbv_typecast on it.
 exprt translator::get_expr_uitofp(const UIToFPInst &UITFP) {
-  exprt expr;
   const auto &ll_op1 = UITFP.getOperand(0);
   const auto &ll_op2 = UITFP.getDestTy();
-  expr = get_expr(*ll_op1);
-  if (expr.type().id() == ID_bool)
-    expr = typecast_exprt(expr, unsignedbv_typet(32));
+  const auto lane_type = symbol_util::get_goto_type(ll_op2->getScalarType());
   auto rounding_mode =
       symbol_table.lookup("__CPROVER_rounding_mode")->symbol_expr();
-  if (expr.type().id() == ID_bool)
-    expr = typecast_exprt(expr, unsignedbv_typet(32));
-  expr = floatbv_typecast_exprt(expr, rounding_mode,
-                                symbol_util::get_goto_type(ll_op2));
-  return expr;
+  return lane_wise(symbol_util::get_goto_type(ll_op2), {get_expr(*ll_op1)},
+                   [&](const exprt::operandst &ops) -> exprt {
+                     auto expr = ops[0];
+                     if (expr.type().id() == ID_bool)
+                       expr = typecast_exprt(expr, unsignedbv_typet(32));
+                     return floatbv_typecast_exprt(expr, rounding_mode,
+                                                   lane_type);
+                   });
 }
 
 /// Translates FPTruncInst. By doing
 ///	a floatbv_typecast on it.
 exprt translator::get_expr_fptrunc(const FPTruncInst &FPTI) {
-  exprt expr;
   const auto &ll_op1 = FPTI.getOperand(0);
   const auto &ll_op2 = FPTI.getDestTy();
-  expr = get_expr(*ll_op1);
+  const auto lane_type = symbol_util::get_goto_type(ll_op2->getScalarType());
   auto rounding_mode =
       symbol_table.lookup("__CPROVER_rounding_mode")->symbol_expr();
-  expr = floatbv_typecast_exprt(expr, rounding_mode,
-                                symbol_util::get_goto_type(ll_op2));
-  return expr;
+  return lane_wise(symbol_util::get_goto_type(ll_op2), {get_expr(*ll_op1)},
+                   [&](const exprt::operandst &ops) -> exprt {
+                     return floatbv_typecast_exprt(ops[0], rounding_mode,
+                                                   lane_type);
+                   });
 }
 
 /// Translates FNegInst. By doing
@@ -865,28 +976,36 @@ exprt translator::get_expr_select(const SelectInst &SI) {
   auto cond_expr = get_expr(*ll_op1);
   auto op1_expr = get_expr(*ll_op2);
   auto op2_expr = get_expr(*ll_op3);
-  expr = ternary_exprt(ID_if, cond_expr, op1_expr, op2_expr, op1_expr.type());
+  if (cond_expr.type().id() == ID_vector)
+    expr = lane_wise(op1_expr.type(), {cond_expr, op1_expr, op2_expr},
+                     [](const exprt::operandst &ops) -> exprt {
+                       return if_exprt(ops[0], ops[1], ops[2]);
+                     });
+  else
+    expr = ternary_exprt(ID_if, cond_expr, op1_expr, op2_expr, op1_expr.type());
   return expr;
 }
 
 /// Translates and returns a sign extended integer.
 /// Sign extension is dont by a simple typecast.
 exprt translator::get_expr_sext(const SExtInst &SI) {
-  exprt expr;
   const auto &ll_op1 = SI.getOperand(0);
   const auto &ll_op2 = SI.getDestTy();
-  expr = get_expr(*ll_op1);
-  /// If it's a i1 llvm value, then because of 2's complement
-  /// representation true and false are -1 & 0 instead of 1 & 0.
-  /// The following if block takes care of this scenario.
-  if (SI.getOperand(0)->getType()->getIntegerBitWidth() == 1) {
-    expr = ternary_exprt(ID_if, equal_exprt(expr, from_integer(0, expr.type())),
-                         from_integer(0, symbol_util::get_goto_type(ll_op2)),
-                         from_integer(-1, symbol_util::get_goto_type(ll_op2)),
-                         symbol_util::get_goto_type(ll_op2));
-  } else
-    expr = typecast_exprt(expr, symbol_util::get_goto_type(ll_op2));
-  return expr;
+  const auto lane_type = symbol_util::get_goto_type(ll_op2->getScalarType());
+  const bool from_bool = ll_op1->getType()->getScalarSizeInBits() == 1;
+  return lane_wise(
+      symbol_util::get_goto_type(ll_op2), {get_expr(*ll_op1)},
+      [&lane_type, from_bool](const exprt::operandst &ops) -> exprt {
+        /// If it's a i1 llvm value, then because of 2's complement
+        /// representation true and false are -1 & 0 instead of 1 & 0.
+        /// The following if block takes care of this scenario.
+        if (from_bool)
+          return ternary_exprt(
+              ID_if, equal_exprt(ops[0], from_integer(0, ops[0].type())),
+              from_integer(0, lane_type), from_integer(-1, lane_type),
+              lane_type);
+        return typecast_exprt(ops[0], lane_type);
+      });
 }
 
 /// This performs zero extension on an exprt. By
@@ -897,18 +1016,19 @@ exprt translator::get_expr_sext(const SExtInst &SI) {
 /// eg, to extend i32 x to i64, we do
 /// i64 val = ((signed long)x) & 0x0000000011111111.
 exprt translator::get_expr_zext(const ZExtInst &ZI) {
-  exprt expr;
   const auto &ll_op1 = ZI.getOperand(0);
   const auto &ll_op2 = ZI.getDestTy();
-  expr = get_expr(*ll_op1);
-  expr = typecast_exprt(expr, symbol_util::get_goto_type(ll_op2));
+  const auto lane_type = symbol_util::get_goto_type(ll_op2->getScalarType());
   unsigned long long zext_and = 1u;
-  zext_and <<= ll_op1->getType()->getIntegerBitWidth();
+  zext_and <<= ll_op1->getType()->getScalarSizeInBits();
   zext_and--;
-  auto zext_expr =
-      from_integer(zext_and, signedbv_typet(ll_op2->getIntegerBitWidth()));
-  expr = bitand_exprt(expr, zext_expr);
-  return expr;
+  const auto zext_expr =
+      from_integer(zext_and, signedbv_typet(ll_op2->getScalarSizeInBits()));
+  return lane_wise(symbol_util::get_goto_type(ll_op2), {get_expr(*ll_op1)},
+                   [&](const exprt::operandst &ops) -> exprt {
+                     return bitand_exprt(typecast_exprt(ops[0], lane_type),
+                                         zext_expr);
+                   });
 }
 
 /// Translates load instruction. By returning
@@ -922,9 +1042,16 @@ exprt translator::get_expr_zext(const ZExtInst &ZI) {
 /// we always dereference on a load and instead,
 ///	all value producing instructions must return
 ///	the address to ther value instead.
+/// Loads at a constant offset into a constant global are
+/// folded to the loaded value instead.
 exprt translator::get_expr_load(const LoadInst &LI) {
   exprt expr;
   const auto &ll_op1 = LI.getOperand(0);
+  if (!LI.isVolatile() && isa<Constant>(ll_op1))
+    if (auto *folded = ConstantFoldLoadFromConstPtr(
+            cast<Constant>(ll_op1), LI.getType(),
+            llvm_module->getDataLayout()))
+      return get_expr(*folded);
   expr = dereference_exprt(get_expr(*ll_op1));
   return expr;
 }
@@ -955,6 +1082,68 @@ exprt translator::get_expr_extractvalue(const ExtractValueInst &EVI) {
   return expr;
 }
 
+/// Translates ExtractElementInst. By indexing into the vector.
+exprt translator::get_expr_extractelement(const ExtractElementInst &EEI) {
+  auto vec_expr = get_expr(*EEI.getVectorOperand());
+  auto index_expr = typecast_exprt::conditional_cast(
+      get_expr(*EEI.getIndexOperand()), index_type());
+  return index_exprt(vec_expr, index_expr,
+                     symbol_util::get_goto_type(EEI.getType()));
+}
+
+/// Translates InsertElementInst. By rebuilding the vector
+/// with the element at the index replaced, every lane is
+/// guarded by a comparison if the index is not constant.
+exprt translator::get_expr_insertelement(const InsertElementInst &IEI) {
+  auto vec_expr = get_expr(*IEI.getOperand(0));
+  auto elem_expr = get_expr(*IEI.getOperand(1));
+  const auto &ll_index = IEI.getOperand(2);
+  const auto &vec_type = to_vector_type(vec_expr.type());
+  const auto lanes = cast<FixedVectorType>(IEI.getType())->getNumElements();
+  exprt::operandst lane_exprs;
+  for (unsigned i = 0; i < lanes; i++) {
+    const auto lane_index = from_integer(i, index_type());
+    exprt lane_expr = index_exprt(vec_expr, lane_index, elem_expr.type());
+    if (isa<ConstantInt>(ll_index)) {
+      if (cast<ConstantInt>(ll_index)->getZExtValue() == i)
+        lane_expr = elem_expr;
+    } else {
+      auto index_expr = typecast_exprt::conditional_cast(get_expr(*ll_index),
+                                                         index_type());
+      lane_expr = if_exprt(equal_exprt(index_expr, lane_index), elem_expr,
+                           lane_expr);
+    }
+    lane_exprs.push_back(lane_expr);
+  }
+  return vector_exprt(lane_exprs, vec_type);
+}
+
+/// Translates ShuffleVectorInst. By picking every lane of
+/// the result from either operand as given by the mask.
+/// Undefined lanes are left nondeterministic.
+exprt translator::get_expr_shufflevector(const ShuffleVectorInst &SVI) {
+  auto op1_expr = get_expr(*SVI.getOperand(0));
+  auto op2_expr = get_expr(*SVI.getOperand(1));
+  const auto &type = to_vector_type(symbol_util::get_goto_type(SVI.getType()));
+  const auto lane_type =
+      symbol_util::get_goto_type(SVI.getType()->getScalarType());
+  const int op1_lanes =
+      cast<FixedVectorType>(SVI.getOperand(0)->getType())->getNumElements();
+  exprt::operandst lane_exprs;
+  for (auto mask : SVI.getShuffleMask()) {
+    if (mask == UndefMaskElem)
+      lane_exprs.push_back(
+          side_effect_expr_nondett(lane_type, source_locationt()));
+    else if (mask < op1_lanes)
+      lane_exprs.push_back(
+          index_exprt(op1_expr, from_integer(mask, index_type()), lane_type));
+    else
+      lane_exprs.push_back(index_exprt(
+          op2_expr, from_integer(mask - op1_lanes, index_type()), lane_type));
+  }
+  return vector_exprt(lane_exprs, type);
+}
+
 ///	Translates GEP instructions.
 ///	This one of the most complicated
 ///	translations, take extra CAUTION
@@ -966,7 +1155,7 @@ exprt translator::get_expr_gep(const GetElementPtrInst &GEPI) {
   for (auto i = 1u, n = GEPI.getNumOperands(); i < n; i++)
     if (expr.type().id() == ID_pointer)
       expr = dereference_exprt(plus_exprt(expr, get_expr(*GEPI.getOperand(i))));
-    else if (expr.type().id() == ID_array)
+    else if (expr.type().id() == ID_array || expr.type().id() == ID_vector)
       expr = index_exprt(expr, get_expr(*GEPI.getOperand(i)));
     else if (expr.type().id() == ID_struct ||
              expr.type().id() == ID_struct_tag) {
@@ -1046,6 +1235,21 @@ exprt translator::get_expr(const Value &V, bool new_state_required) {
       expr = get_expr_extractvalue(*EVI);
       break;
     }
+    case Instruction::ExtractElement: {
+      const auto &EEI = cast<ExtractElementInst>(&I);
+      expr = get_expr_extractelement(*EEI);
+      break;
+    }
+    case Instruction::InsertElement: {
+      const auto &IEI = cast<InsertElementInst>(&I);
+      expr = get_expr_insertelement(*IEI);
+      break;
+    }
+    case Instruction::ShuffleVector: {
+      const auto &SVI = cast<ShuffleVectorInst>(&I);
+      expr = get_expr_shufflevector(*SVI);
+      break;
+    }
     case Instruction::GetElementPtr: {
       const auto &GEPI = cast<GetElementPtrInst>(&I);
       expr = get_expr_gep(*GEPI);
@@ -1237,7 +1441,6 @@ exprt translator::get_expr(const Value &V, bool new_state_required) {
       error_state = "duplicate symbol names encountered!";
     }
     goto_program.add(goto_programt::make_assignment(sym.symbol_expr(), expr));
-    goto_program.update();
     state_map[&V] = sym.symbol_expr();
     return sym.symbol_expr();
   }
@@ -1262,10 +1465,9 @@ void translator::trans_alloca(const AllocaInst &AI) {
     auto DI = alloca_dbg_map[&AI]->getVariable();
     if (!DI->getName().str().compare(""))
       goto L1;
-    symbol.name = scope_name_map
-                      .find(dyn_cast<DILocalScope>(DI->getScope())
-                                ->getNonLexicalBlockFileScope())
-                      ->second +
+    symbol.name = scopes->get_scope_name(
+                      dyn_cast<DILocalScope>(DI->getScope())
+                          ->getNonLexicalBlockFileScope()) +
                   "::" + DI->getName().str();
     symbol.base_name = DI->getName().str();
     symbol.location = location;
@@ -1303,34 +1505,18 @@ void translator::trans_alloca(const AllocaInst &AI) {
     aux_name_map[aux_symbol.name.c_str()] = var_name_map[&I];
     var_name_map[&I] = aux_symbol.name.c_str();
   }
-  goto_program.update();
 }
 
-/// This adds one or two skip instuctions. Since the target
-/// BB may not have been translated yet, we add skips, and later
-/// once the BB has been translated we will change the skips to
-/// GOTO instructions.
+/// This adds one or two GOTO instuctions. Since the target
+/// BB may not have been translated yet, their targets are
+/// set once the whole function has been translated.
 void translator::trans_br(const BranchInst &BI) {
-  auto location = get_location(BI);
   if (BI.isConditional()) {
     auto guard_expr = not_exprt(get_expr(*BI.getCondition()));
-    auto cond_true = goto_program.add_instruction(GOTO);
-    auto cond_false = goto_program.add_instruction(GOTO);
-    br_instr_target_map[&BI] =
-        pair<goto_programt::targett, goto_programt::targett>(cond_true,
-                                                             cond_false);
-    cond_true->set_condition(guard_expr);
-    cond_true->set_target(cond_false);
-    cond_false->set_condition(true_exprt());
-    cond_false->set_target(cond_true);
-  } else {
-    auto br_ins = goto_program.add_instruction(GOTO);
-    br_instr_target_map[&BI] =
-        pair<goto_programt::targett, goto_programt::targett>(br_ins, br_ins);
-    br_ins->set_target(br_ins);
-    br_ins->set_condition(true_exprt());
-  }
-  goto_program.update();
+    add_block_goto(guard_expr, BI.getSuccessor(1));
+    add_block_goto(true_exprt(), BI.getSuccessor(0));
+  } else
+    add_block_goto(true_exprt(), BI.getSuccessor(0));
 }
 
 /// Translates and adds a function call instruction.
@@ -1373,17 +1559,14 @@ void translator::trans_call(const CallInst &CI) {
       auto comment = file_name + ":" + to_string(line_no) + ": " + func_name +
                      ": " + asrt_comment;
       assert_inst->source_location_nonconst().set_comment(comment.str());
-      goto_program.update();
     } else if (!called_func->getName().str().compare(
                    "reach_error")) { /// reach_error is the error definition for
                                      /// SV-COMP 20
       goto_program.add(goto_programt::make_assertion(false_exprt(), location));
-      goto_program.update();
     } else if (!called_func->getName().str().compare(
                    "abort")) { /// abort in SV-COMP 20 should stop Verification
                                /// at that point
       goto_program.add(goto_programt::make_assumption(false_exprt(), location));
-      goto_program.update();
     } else if (called_func->isDeclaration())
       goto L1;
     else
@@ -1404,15 +1587,12 @@ void translator::trans_call(const CallInst &CI) {
           goto_program.add(goto_programt::make_assertion(guard_expr, location));
       assert_inst->source_location_nonconst().set_comment(
           "assertion " + from_expr(namespacet(symbol_table), "", guard_expr));
-      goto_program.update();
     } else if (is_assert_fail_function(called_val->getName().str())) {
       goto_program.add(goto_programt::make_assertion(false_exprt(), location));
-      goto_program.update();
     } else if (is_assume_function(called_val->getName().str())) {
       auto guard_expr =
           typecast_exprt(get_expr(*CI.getOperand(0)), bool_typet());
       goto_program.add(goto_programt::make_assumption(guard_expr, location));
-      goto_program.update();
     } else if (is_intrinsic_function(called_val->getName().str())) {
       add_intrinsic_support(*called_func); /// General Intrinsic functions, like
                                            /// fpclassify, fesetround, etc
@@ -1450,7 +1630,6 @@ void translator::trans_call(const CallInst &CI) {
         call_ret_sym_map[&CI] = ret_symbol.name.c_str();
         goto_program.add(goto_programt::make_decl(
             code_declt(ret_symbol.symbol_expr()), location));
-        goto_program.update();
       }
       for (auto func_sym : actual_symbols) {
         call_func_expr = func_sym->symbol_expr();
@@ -1548,11 +1727,111 @@ void translator::make_func_call(const CallInst &CI) {
     call_ret_sym_map[&CI] = ret_symbol.name.c_str();
     goto_program.add(
         goto_programt::make_decl(ret_symbol.symbol_expr(), location));
-    goto_program.update();
   }
   goto_program.add(goto_programt::make_function_call(call_expr, location));
 }
 
+/// Returns the type of the object V points to the start of,
+/// if V covers a whole alloca or global, else nullptr.
+static Type *whole_object_type(const Value *V) {
+  V = V->stripPointerCasts();
+  if (const auto *AI = dyn_cast<AllocaInst>(V))
+    return AI->isArrayAllocation() ? nullptr : AI->getAllocatedType();
+  if (const auto *GV = dyn_cast<GlobalVariable>(V))
+    return GV->getValueType();
+  return nullptr;
+}
+
+/// Returns the type V points to once casts are stripped,
+/// if len bytes are exactly one object of that type.
+static Type *pointee_of_size(const Value *V, uint64_t len,
+                             const DataLayout &DL) {
+  auto *T = V->stripPointerCasts()->getType()->getPointerElementType();
+  return T->isSized() && DL.getTypeAllocSize(T) == len ? T : nullptr;
+}
+
+/// Lowers a memcpy of a constant length without a temporary
+/// array where possible: a typed assignment if source and
+/// target are objects of the same type and exactly len bytes,
+/// else a single array_copy (array_replace) when the target
+/// (source) is a whole array of len bytes. Returns false if
+/// none applies.
+bool translator::trans_memcpy_direct(const MemCpyInst &MCI) {
+  const auto *ll_len = dyn_cast<ConstantInt>(MCI.getLength());
+  if (!ll_len)
+    return false;
+  const auto len = ll_len->getZExtValue();
+  const auto &DL = llvm_module->getDataLayout();
+  const auto *ll_target = MCI.getRawDest();
+  const auto *ll_source = MCI.getRawSource();
+  auto location = get_location(MCI);
+
+  auto *target_type = pointee_of_size(ll_target, len, DL);
+  if (target_type && target_type == pointee_of_size(ll_source, len, DL)) {
+    auto target_expr =
+        dereference_exprt(get_expr(*ll_target->stripPointerCasts()));
+    auto source_expr =
+        dereference_exprt(get_expr(*ll_source->stripPointerCasts()));
+    goto_program.add(
+        goto_programt::make_assignment(target_expr, source_expr, location));
+    return true;
+  }
+
+  irep_idt statement;
+  if (auto *T = whole_object_type(ll_target))
+    if (T->isArrayTy() && DL.getTypeAllocSize(T) == len)
+      statement = ID_array_copy;
+  if (statement.empty())
+    if (auto *T = whole_object_type(ll_source))
+      if (T->isArrayTy() && DL.getTypeAllocSize(T) == len)
+        statement = ID_array_replace;
+  if (statement.empty())
+    return false;
+  auto copy_code = codet(statement);
+  copy_code.operands().push_back(get_expr(*ll_target));
+  copy_code.operands().push_back(get_expr(*ll_source));
+  goto_program.add(goto_programt::make_other(copy_code, location));
+  return true;
+}
+
+/// Lowers a memset of a constant length without a temporary
+/// array where possible: zeroing a whole object of len bytes
+/// assigns its zero initializer, and setting a whole byte
+/// array of len bytes is a single array_set. Returns false
+/// if neither applies.
+bool translator::trans_memset_direct(const MemSetInst &MSI) {
+  const auto *ll_len = dyn_cast<ConstantInt>(MSI.getLength());
+  if (!ll_len)
+    return false;
+  const auto len = ll_len->getZExtValue();
+  const auto &DL = llvm_module->getDataLayout();
+  const auto *ll_target = MSI.getRawDest();
+  auto location = get_location(MSI);
+
+  const auto *ll_val = dyn_cast<ConstantInt>(MSI.getValue());
+  if (ll_val && ll_val->isZero())
+    if (auto *T = pointee_of_size(ll_target, len, DL)) {
+      auto zero = zero_initializer(symbol_util::get_goto_type(T), location,
+                                   namespacet(symbol_table));
+      if (zero) {
+        goto_program.add(goto_programt::make_assignment(
+            dereference_exprt(get_expr(*ll_target->stripPointerCasts())),
+            *zero, location));
+        return true;
+      }
+    }
+
+  auto *T = whole_object_type(ll_target);
+  if (!T || !T->isArrayTy() || DL.getTypeAllocSize(T) != len ||
+      !T->getArrayElementType()->isIntegerTy(8))
+    return false;
+  auto array_set_code = codet(ID_array_set);
+  array_set_code.operands().push_back(get_expr(*ll_target));
+  array_set_code.operands().push_back(get_expr(*MSI.getValue()));
+  goto_program.add(goto_programt::make_other(array_set_code, location));
+  return true;
+}
+
 /// Translates all the intrinsics of llvm.
 /// dbg intrinsics are ignored
 /// memcpy is implemented as an assignment.
@@ -1563,7 +1842,6 @@ void translator::trans_call_llvm_intrinsic(const IntrinsicInst &ICI) {
     const auto &cond = ICI.getArgOperand(0);
     auto guard_expr = typecast_exprt(get_expr(*cond), bool_typet());
     goto_program.add(goto_programt::make_assumption(guard_expr, location));
-    goto_program.update();
     break;
   }
   case Intrinsic::memcpy: {
@@ -1571,6 +1849,9 @@ void translator::trans_call_llvm_intrinsic(const IntrinsicInst &ICI) {
     //		make_func_call(ICI);
     //		break;
     const auto &MCI = cast<MemCpyInst>(ICI);
+    if (trans_memcpy_direct(MCI))
+      break;
+    /// Fall back to copying through a temporary byte array.
     const auto &ll_target = MCI.getOperand(0);
     const auto &ll_source = MCI.getOperand(1);
     const auto &ll_len = MCI.getOperand(2);
@@ -1605,11 +1886,13 @@ void translator::trans_call_llvm_intrinsic(const IntrinsicInst &ICI) {
     array_replace_code.operands().push_back(target_expr);
     array_replace_code.operands().push_back(new_arr);
     goto_program.add(goto_programt::make_other(array_replace_code, location));
-    goto_program.update();
     break;
   }
   case Intrinsic::memset: {
     const auto &MSI = cast<MemSetInst>(ICI);
+    if (trans_memset_direct(MSI))
+      break;
+    /// Fall back to setting a temporary byte array.
     const auto &ll_target = MSI.getOperand(0);
     const auto &ll_val = MSI.getOperand(1);
     const auto &ll_len = MSI.getOperand(2);
@@ -1644,7 +1927,6 @@ void translator::trans_call_llvm_intrinsic(const IntrinsicInst &ICI) {
     array_replace_code.operands().push_back(target_expr);
     array_replace_code.operands().push_back(new_arr);
     goto_program.add(goto_programt::make_other(array_replace_code, location));
-    goto_program.update();
     break;
   }
   case Intrinsic::ceil: {
@@ -1701,27 +1983,43 @@ void translator::trans_call_llvm_intrinsic(const IntrinsicInst &ICI) {
   }
   case Intrinsic::trap: {
     goto_program.add(goto_programt::make_assumption(false_exprt(), location));
-    goto_program.update();
     break;
   }
   case Intrinsic::stacksave: {
-    auto called_func = ICI.getCalledFunction();
-    auto ret_symbol = symbol_util::create_symbol(called_func->getReturnType());
-    if (ICI.hasName()) {
-      ret_symbol.base_name = ICI.getName().str();
-      ret_symbol.name = ICI.getFunction()->getName().str() +
-                        "::" + ret_symbol.base_name.c_str();
-    } else
-      ret_symbol.name =
-          ICI.getFunction()->getName().str() + "::" + ret_symbol.name.c_str();
-    if (symbol_table.add(ret_symbol)) {
-      error_state = "duplicate symbol names encountered!";
-    }
-    goto_program.add(goto_programt::make_assignment(
-        ret_symbol.symbol_expr(),
-        side_effect_expr_nondett(ret_symbol.type, source_locationt::nil())));
-    goto_program.update();
-    call_ret_sym_map[&ICI] = ret_symbol.name.c_str();
+    assign_intrinsic_result(
+        ICI, side_effect_expr_nondett(
+                 symbol_util::get_goto_type(ICI.getType()), location));
+    break;
+  }
+  case Intrinsic::sadd_with_overflow:
+  case Intrinsic::uadd_with_overflow:
+  case Intrinsic::ssub_with_overflow:
+  case Intrinsic::usub_with_overflow:
+  case Intrinsic::smul_with_overflow:
+  case Intrinsic::umul_with_overflow: {
+    trans_overflow_intrinsic(ICI);
+    break;
+  }
+  case Intrinsic::ctpop:
+  case Intrinsic::ctlz:
+  case Intrinsic::cttz:
+  case Intrinsic::bswap:
+  case Intrinsic::bitreverse:
+  case Intrinsic::fshl:
+  case Intrinsic::fshr: {
+    trans_bit_intrinsic(ICI);
+    break;
+  }
+  case Intrinsic::smax:
+  case Intrinsic::smin:
+  case Intrinsic::umax:
+  case Intrinsic::umin:
+  case Intrinsic::abs:
+  case Intrinsic::sadd_sat:
+  case Intrinsic::uadd_sat:
+  case Intrinsic::ssub_sat:
+  case Intrinsic::usub_sat: {
+    trans_arith_intrinsic(ICI);
     break;
   }
   case Intrinsic::dbg_declare:
@@ -1734,6 +2032,181 @@ void translator::trans_call_llvm_intrinsic(const IntrinsicInst &ICI) {
   }
 }
 
+/// Stores the value of an intrinsic call that is expanded
+/// inline in a new return symbol, which later uses of the
+/// call read.
+void translator::assign_intrinsic_result(const IntrinsicInst &ICI,
+                                         const exprt &value) {
+  auto ret_symbol = symbol_util::create_symbol(ICI.getType());
+  if (ICI.hasName()) {
+    ret_symbol.base_name = ICI.getName().str();
+    ret_symbol.name = ICI.getFunction()->getName().str() +
+                      "::" + ret_symbol.base_name.c_str();
+  } else
+    ret_symbol.name =
+        ICI.getFunction()->getName().str() + "::" + ret_symbol.name.c_str();
+  if (symbol_table.add(ret_symbol)) {
+    error_state = "duplicate symbol names encountered!";
+  }
+  goto_program.add(goto_programt::make_assignment(
+      ret_symbol.symbol_expr(), value, get_location(ICI)));
+  call_ret_sym_map[&ICI] = ret_symbol.name.c_str();
+}
+
+/// Translates the {s,u}{add,sub,mul}.with.overflow intrinsics
+/// into the struct of the wrapped result and CBMC's overflow
+/// predicate for the operation. The result is computed on
+/// unsigned operands so it wraps without tripping CBMC's
+/// signed overflow checks.
+void translator::trans_overflow_intrinsic(const IntrinsicInst &ICI) {
+  const auto &WOI = cast<WithOverflowInst>(ICI);
+  const auto *ll_type = WOI.getLHS()->getType();
+  if (!ll_type->isIntegerTy()) {
+    error_state = "Unsupported operand type for " +
+                  ICI.getCalledFunction()->getName().str();
+    return;
+  }
+  const auto width = ll_type->getIntegerBitWidth();
+  auto expr_op1 = get_expr(*WOI.getLHS());
+  auto expr_op2 = get_expr(*WOI.getRHS());
+  const unsignedbv_typet unsigned_type(width);
+  auto unsigned_op1 =
+      typecast_exprt::conditional_cast(expr_op1, unsigned_type);
+  auto unsigned_op2 =
+      typecast_exprt::conditional_cast(expr_op2, unsigned_type);
+
+  irep_idt kind;
+  exprt result;
+  switch (WOI.getBinaryOp()) {
+  case Instruction::Add:
+    kind = ID_plus;
+    result = plus_exprt(unsigned_op1, unsigned_op2);
+    break;
+  case Instruction::Sub:
+    kind = ID_minus;
+    result = minus_exprt(unsigned_op1, unsigned_op2);
+    break;
+  default:
+    kind = ID_mult;
+    result = mult_exprt(unsigned_op1, unsigned_op2);
+  }
+  result = typecast_exprt::conditional_cast(result, expr_op1.type());
+  exprt overflow =
+      WOI.isSigned() ? binary_overflow_exprt(expr_op1, kind, expr_op2)
+                     : binary_overflow_exprt(unsigned_op1, kind, unsigned_op2);
+
+  const auto type = symbol_util::get_goto_type(ICI.getType());
+  assign_intrinsic_result(ICI, struct_exprt({result, overflow}, type));
+}
+
+/// Translates the bit manipulation intrinsics into CBMC's
+/// popcount, count leading/trailing zeros, bswap and bitreverse
+/// exprs. Funnel shifts become a pair of shifts, guarded for a
+/// shift amount of zero. Vector forms are done lane by lane.
+void translator::trans_bit_intrinsic(const IntrinsicInst &ICI) {
+  const auto id = ICI.getIntrinsicID();
+  const auto type = symbol_util::get_goto_type(ICI.getType());
+  const auto lane_type =
+      symbol_util::get_goto_type(ICI.getType()->getScalarType());
+  const auto width = ICI.getType()->getScalarSizeInBits();
+  exprt::operandst ops;
+  for (const auto &arg : ICI.args())
+    ops.push_back(get_expr(*arg.get()));
+
+  /// The i1 flag of ctlz and cttz tells if a zero input is poison.
+  bool zero_permitted = true;
+  if (id == Intrinsic::ctlz || id == Intrinsic::cttz) {
+    zero_permitted = cast<ConstantInt>(ICI.getArgOperand(1))->isZero();
+    ops.pop_back();
+  }
+
+  auto value = lane_wise(type, ops, [&](const exprt::operandst &lane_ops) {
+    const auto &op = lane_ops[0];
+    switch (id) {
+    case Intrinsic::ctpop:
+      return exprt(popcount_exprt(op, lane_type));
+    case Intrinsic::ctlz:
+      return exprt(count_leading_zeros_exprt(op, zero_permitted, lane_type));
+    case Intrinsic::cttz:
+      return exprt(count_trailing_zeros_exprt(op, zero_permitted, lane_type));
+    case Intrinsic::bswap:
+      return exprt(bswap_exprt(op, 8, lane_type));
+    case Intrinsic::bitreverse:
+      return exprt(bitreverse_exprt(op));
+    default: {
+      /// fshl(a, b, s) is the high half of a:b << s % width,
+      /// fshr(a, b, s) the low half of a:b >> s % width.
+      const unsignedbv_typet unsigned_type(width);
+      auto a = typecast_exprt::conditional_cast(lane_ops[0], unsigned_type);
+      auto b = typecast_exprt::conditional_cast(lane_ops[1], unsigned_type);
+      auto shift = mod_exprt(
+          typecast_exprt::conditional_cast(lane_ops[2], unsigned_type),
+          from_integer(width, unsigned_type));
+      auto rest = minus_exprt(from_integer(width, unsigned_type), shift);
+      const bool left = id == Intrinsic::fshl;
+      exprt shifted =
+          left ? bitor_exprt(shl_exprt(a, shift), lshr_exprt(b, rest))
+               : bitor_exprt(lshr_exprt(b, shift), shl_exprt(a, rest));
+      return typecast_exprt::conditional_cast(
+          if_exprt(equal_exprt(shift, from_integer(0, unsigned_type)),
+                   left ? a : b, shifted),
+          lane_type);
+    }
+    }
+  });
+  assign_intrinsic_result(ICI, value);
+}
+
+/// Translates the min/max, abs and saturating arithmetic
+/// intrinsics into if, abs and saturating plus/minus exprs,
+/// comparing and computing on unsigned operands for the u
+/// variants. Vector forms are done lane by lane.
+void translator::trans_arith_intrinsic(const IntrinsicInst &ICI) {
+  const auto id = ICI.getIntrinsicID();
+  const auto type = symbol_util::get_goto_type(ICI.getType());
+  const auto lane_type =
+      symbol_util::get_goto_type(ICI.getType()->getScalarType());
+  const unsignedbv_typet unsigned_type(ICI.getType()->getScalarSizeInBits());
+  exprt::operandst ops{get_expr(*ICI.getArgOperand(0))};
+  /// The second operand of abs is its is-int-min-poison flag.
+  /// It is dropped: abs_exprt negates with wrap around, so
+  /// abs(INT_MIN) is INT_MIN, the defined result when the flag
+  /// is clear. When it is set that input is poison, and the
+  /// wrapped value is kept rather than reported.
+  if (id != Intrinsic::abs)
+    ops.push_back(get_expr(*ICI.getArgOperand(1)));
+
+  auto value = lane_wise(type, ops, [&](const exprt::operandst &lane_ops) {
+    const auto &a = lane_ops[0];
+    if (id == Intrinsic::abs)
+      return exprt(abs_exprt(a));
+    const auto &b = lane_ops[1];
+    auto a_u = typecast_exprt::conditional_cast(a, unsigned_type);
+    auto b_u = typecast_exprt::conditional_cast(b, unsigned_type);
+    switch (id) {
+    case Intrinsic::smax:
+      return exprt(if_exprt(binary_relation_exprt(a, ID_gt, b), a, b));
+    case Intrinsic::smin:
+      return exprt(if_exprt(binary_relation_exprt(a, ID_lt, b), a, b));
+    case Intrinsic::umax:
+      return exprt(if_exprt(binary_relation_exprt(a_u, ID_gt, b_u), a, b));
+    case Intrinsic::umin:
+      return exprt(if_exprt(binary_relation_exprt(a_u, ID_lt, b_u), a, b));
+    case Intrinsic::sadd_sat:
+      return exprt(saturating_plus_exprt(a, b));
+    case Intrinsic::ssub_sat:
+      return exprt(saturating_minus_exprt(a, b));
+    case Intrinsic::uadd_sat:
+      return typecast_exprt::conditional_cast(saturating_plus_exprt(a_u, b_u),
+                                              lane_type);
+    default:
+      return typecast_exprt::conditional_cast(saturating_minus_exprt(a_u, b_u),
+                                              lane_type);
+    }
+  });
+  assign_intrinsic_result(ICI, value);
+}
+
 /// Translates InsertValueInst.
 ///	This is modeled as an assignment to an array.
 void translator::trans_insertvalue(const InsertValueInst &IVI) {
@@ -1760,7 +2233,6 @@ void translator::trans_insertvalue(const InsertValueInst &IVI) {
   }
   goto_program.add(goto_programt::make_assignment(
       code_assignt(tgt_expr, src_expr), get_location(IVI)));
-  goto_program.update();
 }
 
 /// Translates and adds a return instr.
@@ -1771,11 +2243,68 @@ void translator::trans_ret(const ReturnInst &RI) {
         goto_programt::make_set_return_value(ret_expr, get_location(RI)));
   }
 
-  /// Change these to GOTO END FUNCTION later, we don't use
-  /// incomplete_goto instr anywhere else, hence we can convert,
-  /// every incomplete_goto to goto END FUNCTION.
-  goto_program.add(goto_programt::make_incomplete_goto());
-  goto_program.update();
+  /// Change these to GOTO END FUNCTION later, once
+  /// END FUNCTION has been added.
+  return_gotos.push_back(
+      goto_program.add(goto_programt::make_incomplete_goto()));
+}
+
+/// Adds ASSUMEs for the facts the IR states about the value
+/// of I: !range metadata on loads and calls, and nonnull or
+/// dereferenceable returns. Without noundef these only say
+/// the value is poison otherwise, which is not UB until it
+/// is used, so they are only assumed for noundef values.
+void translator::assume_annotations(const Instruction &I) {
+  const auto *ll_type = I.getType();
+  const bool is_int = ll_type->isIntegerTy() && !ll_type->isIntegerTy(1);
+  exprt::operandst facts;
+  const auto *CI = dyn_cast<CallInst>(&I);
+  const bool has_value =
+      (isa<LoadInst>(I) && I.hasMetadata(LLVMContext::MD_noundef)) ||
+      (CI && CI->hasRetAttr(Attribute::NoUndef) && call_ret_sym_map.count(CI));
+  const auto *range = I.getMetadata(LLVMContext::MD_range);
+  if (has_value && is_int && range && ll_type->getIntegerBitWidth() <= 64) {
+    /// Each [lo, hi) pair may wrap, so v is in it iff
+    /// v - lo < hi - lo, unsigned.
+    const unsignedbv_typet type(ll_type->getIntegerBitWidth());
+    auto value = typecast_exprt::conditional_cast(get_expr(I), type);
+    exprt::operandst ranges;
+    for (unsigned i = 0; i + 1 < range->getNumOperands(); i += 2) {
+      const auto &lo =
+          mdconst::extract<ConstantInt>(range->getOperand(i))->getValue();
+      const auto &hi =
+          mdconst::extract<ConstantInt>(range->getOperand(i + 1))->getValue();
+      ranges.push_back(binary_relation_exprt(
+          minus_exprt(value, from_integer(lo.getZExtValue(), type)), ID_lt,
+          from_integer((hi - lo).getZExtValue(), type)));
+    }
+    facts.push_back(disjunction(ranges));
+  }
+  if (has_value && CI && ll_type->isPointerTy() &&
+      (CI->hasRetAttr(Attribute::NonNull) ||
+       CI->getRetDereferenceableBytes() > 0)) {
+    auto value = get_expr(I);
+    facts.push_back(notequal_exprt(
+        value, null_pointer_exprt(to_pointer_type(value.type()))));
+  }
+
+  auto location = get_location(I);
+  for (const auto &fact : facts)
+    goto_program.add(goto_programt::make_assumption(fact, location));
+}
+
+/// Translates UnreachableInst. Reaching it is undefined
+/// behaviour, so by default the path is cut with assume(false)
+/// and with -unreachable-assert it is reported as a failure.
+void translator::trans_unreachable(const UnreachableInst &UI) {
+  auto location = get_location(UI);
+  if (unreachableAssert) {
+    auto assert_inst = goto_program.add(
+        goto_programt::make_assertion(false_exprt(), location));
+    assert_inst->source_location_nonconst().set_comment(
+        "unreachable instruction reached");
+  } else
+    goto_program.add(goto_programt::make_assumption(false_exprt(), location));
 }
 
 /// Translate and add an Assignment Instruction.
@@ -1786,21 +2315,101 @@ void translator::trans_store(const StoreInst &SI) {
   auto tgt_expr = dereference_exprt(get_expr(*ll_op2));
   goto_program.add(
       goto_programt::make_assignment(tgt_expr, src_expr, get_location(SI)));
-  goto_program.update();
 }
 
-/// Add skip instructions for each switch case + 1 for
-/// the default/epilog case.
+/// Adds the gotos that pick the case of the switch condition
+/// select_expr among cases[begin, end), which are sorted and
+/// disjoint. Small sets of cases are tested one after the
+/// other, larger ones are split in half on the first value of
+/// the upper half, giving a balanced decision tree.
+void translator::add_switch_tree(const exprt &select_expr,
+                                 const vector<switch_ranget> &cases,
+                                 size_t begin, size_t end,
+                                 const BasicBlock *default_dest) {
+  if (end - begin <= 3) {
+    for (auto i = begin; i < end; i++) {
+      const auto &range = cases[i];
+      if (range.low == range.high)
+        add_block_goto(equal_exprt(select_expr, get_expr(*range.low)),
+                       range.dest);
+      else
+        add_block_goto(
+            and_exprt(binary_relation_exprt(select_expr, ID_ge,
+                                            get_expr(*range.low)),
+                      binary_relation_exprt(select_expr, ID_le,
+                                            get_expr(*range.high))),
+            range.dest);
+    }
+    add_block_goto(true_exprt(), default_dest);
+    return;
+  }
+  auto mid = begin + (end - begin) / 2;
+  auto upper_half = goto_program.add_instruction(GOTO);
+  upper_half->set_condition(
+      binary_relation_exprt(select_expr, ID_ge, get_expr(*cases[mid].low)));
+  add_switch_tree(select_expr, cases, begin, mid, default_dest);
+  upper_half->set_target(goto_program.add(goto_programt::make_skip()));
+  add_switch_tree(select_expr, cases, mid, end, default_dest);
+}
+
+/// Add a guarded goto for each switch case + 1 for
+/// the default/epilog case. The guards compare the cases
+/// against a temp holding the condition. With
+/// -switch-tree-threshold, switches with at least that many
+/// cases are lowered into a decision tree over ranges of
+/// consecutive case values sharing a destination instead.
 void translator::trans_switch(const SwitchInst &SI) {
-  auto location = get_location(SI);
-  auto i = SI.getNumCases();
-  while (i--) {
-    auto skip_instr = goto_program.add_instruction(GOTO);
-    switch_instr_target_map[&SI].push_back(skip_instr);
-  }
-  auto skip_instr = goto_program.add_instruction(GOTO);
-  switch_instr_target_map[&SI].push_back(skip_instr);
-  goto_program.update();
+  auto select_expr = get_expr(*SI.getCondition());
+  /// Evaluate the condition once into a temp rather than
+  /// repeating its expression in every case guard.
+  if (select_expr.id() != ID_symbol && !select_expr.is_constant()) {
+    auto location = get_location(SI);
+    auto sym = symbol_util::create_symbol(select_expr.type());
+    sym.base_name = string("ll2gb_switch_") + sym.base_name.c_str();
+    sym.name = SI.getFunction()->getName().str() + "::" +
+               sym.base_name.c_str();
+    sym.location = location;
+    if (symbol_table.add(sym)) {
+      error_state = "duplicate symbol names encountered!";
+    }
+    goto_program.add(
+        goto_programt::make_decl(code_declt(sym.symbol_expr()), location));
+    goto_program.add(goto_programt::make_assignment(sym.symbol_expr(),
+                                                    select_expr, location));
+    select_expr = sym.symbol_expr();
+  }
+  const auto &type_id = select_expr.type().id();
+  if (!switchTreeThreshold || SI.getNumCases() < switchTreeThreshold ||
+      (type_id != ID_signedbv && type_id != ID_unsignedbv)) {
+    for (const auto &Case : SI.cases())
+      add_block_goto(equal_exprt(select_expr, get_expr(*Case.getCaseValue())),
+                     Case.getCaseSuccessor());
+    add_block_goto(true_exprt(), SI.getDefaultDest());
+    return;
+  }
+
+  const bool is_signed = type_id == ID_signedbv;
+  auto before = [is_signed](const ConstantInt *a, const ConstantInt *b) {
+    return is_signed ? a->getValue().slt(b->getValue())
+                     : a->getValue().ult(b->getValue());
+  };
+  vector<switch_ranget> cases;
+  for (const auto &Case : SI.cases())
+    cases.push_back({Case.getCaseValue(), Case.getCaseValue(),
+                     Case.getCaseSuccessor()});
+  llvm::sort(cases, [&before](const switch_ranget &a, const switch_ranget &b) {
+    return before(a.low, b.low);
+  });
+  vector<switch_ranget> ranges;
+  for (const auto &range : cases) {
+    if (!ranges.empty() && ranges.back().dest == range.dest &&
+        (ranges.back().high->getValue() + 1) == range.low->getValue() &&
+        before(ranges.back().high, range.low))
+      ranges.back().high = range.high;
+    else
+      ranges.push_back(range);
+  }
+  add_switch_tree(select_expr, ranges, 0, ranges.size(), SI.getDefaultDest());
 }
 
 /// We only translate instructions that resemble as
@@ -1812,6 +2421,11 @@ bool translator::trans_instruction(const Instruction &I) {
     trans_ret(RI);
     break;
   }
+  case Instruction::Unreachable: {
+    const UnreachableInst &UI = cast<UnreachableInst>(I);
+    trans_unreachable(UI);
+    break;
+  }
   case Instruction::Br: {
     const BranchInst &BI = cast<BranchInst>(I);
     trans_br(BI);
@@ -1865,7 +2479,6 @@ bool translator::trans_instruction(const Instruction &I) {
   case Instruction::Load:
   case Instruction::ICmp:
   case Instruction::FCmp:
-  case Instruction::Unreachable:
   case Instruction::GetElementPtr:
   case Instruction::BitCast:
   case Instruction::PHI:
@@ -1880,10 +2493,15 @@ bool translator::trans_instruction(const Instruction &I) {
   case Instruction::ExtractValue:
   case Instruction::FPTrunc:
   case Instruction::FNeg:
+  case Instruction::ExtractElement:
+  case Instruction::InsertElement:
+  case Instruction::ShuffleVector:
     break;
   default:
     error_state = "Unknown llvmInstruction";
   }
+  if (assumeAnnotations && !check_state())
+    assume_annotations(I);
   if (save_state_values.find(cast<Value>(&I)) != save_state_values.end())
     get_expr(cast<Value>(I));
   return check_state();
@@ -1899,75 +2517,69 @@ bool translator::trans_block(const BasicBlock &BB) {
   return check_state();
 }
 
-/// Once all BB haven been translated, we go back and
-///	and replace the skip instructions we added earlier
-///	br instructions into actual goto instructions.
-void translator::set_branches() {
-  for (auto br_inst_iter = br_instr_target_map.begin(),
-            ie = br_instr_target_map.end();
-       br_inst_iter != ie; br_inst_iter++) {
-    const auto &BI = br_inst_iter->first;
-    if (BI->isConditional()) {
-      auto true_target = block_target_map[BI->getSuccessor(0)];
-      auto false_taget = block_target_map[BI->getSuccessor(1)];
-      //			br_inst_iter->second.first->make_goto(false_taget,
-      // guard_expr);
-      br_inst_iter->second.first->set_target(false_taget);
-      br_inst_iter->second.second->set_target(true_target);
-    } else {
-      goto_programt::targett target;
-      target = block_target_map[BI->getSuccessor(0)];
-      br_inst_iter->second.first->set_target(target);
-    }
-  }
-  br_instr_target_map.clear();
+/// Adds a GOTO to the start of BB, the target is set
+/// by set_targets once all blocks have been translated.
+void translator::add_block_goto(const exprt &guard, const BasicBlock *BB) {
+  auto goto_instr = goto_program.add_instruction(GOTO);
+  goto_instr->set_condition(guard);
+  pending_gotos.emplace_back(goto_instr, block_index[BB]);
 }
 
-/// Once all blocks have been translated
-/// add the goto statements for each case.
-void translator::set_switches() {
-  for (auto sw_inst_iter = switch_instr_target_map.begin(),
-            ie = switch_instr_target_map.end();
-       sw_inst_iter != ie; sw_inst_iter++) {
-    auto SI = sw_inst_iter->first;
-    auto select_expr = get_expr(*SI->getCondition());
-    auto target_vector = sw_inst_iter->second;
-    for (auto i = 1u, n = SI->getNumCases(); i <= n; i++) {
-      auto guard_expr =
-          equal_exprt(select_expr, get_expr(*SI->getOperand(i * 2)));
-      auto target = block_target_map[SI->getSuccessor(i)];
-      target_vector[i - 1]->set_target(target);
-      target_vector[i - 1]->set_condition(guard_expr);
-    }
-    auto default_inst = target_vector.back();
-    auto default_target = block_target_map[SI->getDefaultDest()];
-    default_inst->set_target(default_target);
-    default_inst->set_condition(true_exprt());
-  }
-  switch_instr_target_map.clear();
+/// Once all BB haven been translated, we go back and
+///	point the gotos added for br and switch instructions
+///	to the first instruction of their target blocks.
+void translator::set_targets() {
+  for (auto &pending : pending_gotos)
+    pending.first->set_target(block_targets[pending.second]);
+  pending_gotos.clear();
 }
 
 /// Once END FUNCTION has been realised,
 /// add GOTO END FUNCTION after each return.
 void translator::set_returns(goto_programt::targett &end_func) {
-  for (auto &inst : goto_program.instructions)
-    if (inst.is_incomplete_goto()) {
-      auto temp = goto_programt::make_goto(end_func, true_exprt());
-      inst.swap(temp);
-    }
+  for (auto &ret : return_gotos) {
+    auto temp = goto_programt::make_goto(end_func, true_exprt());
+    ret->swap(temp);
+  }
+  return_gotos.clear();
+}
+
+/// Empties the maps that only live for the translation of
+/// one function and releases their memory in one go.
+void translator::clear_function_maps() {
+  var_name_map.clear();
+  ins_value_name_map.clear();
+  call_ret_sym_map.clear();
+  block_index.clear();
+  block_targets.clear();
+  pending_gotos.clear();
+  return_gotos.clear();
+  state_map.clear();
+  function_arena.Reset();
 }
 
 /// Translates and entire function and writes it
 /// to the 'goto_program'.
 bool translator::trans_function(Function &F) {
+  clear_function_maps();
   symbol_util::set_var_counter(F.arg_size() + 1);
-  scope_tree st;
-  scope_name_map.clear();
-  st.get_scope_name_map(F, &scope_name_map);
-  scope_name_map[nullptr] = "";
+  unsigned index = 0;
+  for (const auto &BB : F)
+    block_index[&BB] = index++;
+  block_targets.reserve(index);
+  /// hasNonNullAttr holds for dereferenceable arguments too,
+  /// unless null is a valid address in their address space.
+  if (assumeAnnotations)
+    for (const auto &A : F.args())
+      if (A.getType()->isPointerTy() && A.hasNonNullAttr() &&
+          A.hasAttribute(Attribute::NoUndef)) {
+        auto arg_expr = get_expr(A);
+        const null_pointer_exprt null(to_pointer_type(arg_expr.type()));
+        goto_program.add(goto_programt::make_assumption(
+            notequal_exprt(arg_expr, null), get_location(F)));
+      }
   for (const auto &BB : F) {
-    auto target = goto_program.add(goto_programt::make_skip());
-    block_target_map[&BB] = target;
+    block_targets.push_back(goto_program.add(goto_programt::make_skip()));
     trans_block(BB);
     if (check_state())
       return true;
@@ -1975,12 +2587,10 @@ bool translator::trans_function(Function &F) {
   if (check_state())
     return true;
   auto end_func = goto_program.add_instruction(END_FUNCTION);
-  set_branches();
-  set_switches();
+  set_targets();
   set_returns(end_func);
   goto_program.update();
   remove_skip(goto_program);
-  state_map.clear();
 
   if (verbose_very) {
     outs().changeColor(outs().BLUE, true);
@@ -1999,18 +2609,26 @@ bool translator::trans_function(Function &F) {
     outs().resetColor();
     outs().flush();
   }
+  clear_function_maps();
   return check_state();
 }
 
 void translator::set_function_symbol_value(
     goto_functionst::function_mapt &function_map, symbol_tablet &symbol_table) {
-  for (auto &func : function_map) {
-    code_blockt cb;
-    for (auto ins : func.second.body.instructions)
-      cb.add(ins.get_code());
-    auto &symbol = symbol_table.get_writeable_ref(func.first);
-    symbol.value.swap(cb);
-  }
+  for (auto &func : function_map)
+    set_function_symbol_value(func.first, func.second.body, symbol_table);
+}
+
+/// Sets the code of body as the value of the function symbol
+/// name.
+void translator::set_function_symbol_value(const irep_idt &name,
+                                           const goto_programt &body,
+                                           symbol_tablet &symbol_table) {
+  code_blockt cb;
+  for (const auto &ins : body.instructions)
+    cb.add(ins.get_code());
+  auto &symbol = symbol_table.get_writeable_ref(name);
+  symbol.value.swap(cb);
 }
 
 void translator::set_entry_point(goto_functionst &goto_functions,
@@ -2048,6 +2666,12 @@ bool translator::trans_module() {
     goto_functions.function_map.find(F->getName().str())
         ->second.set_parameter_identifiers(to_code_type(fn->type));
     goto_program.clear();
+    if (streamOutput) {
+      // A copy of the body in the symbol value would keep it in
+      // memory, so the value is only marked as defined.
+      symbol_table.get_writeable_ref(fn->name).value = code_blockt();
+      spool_function(fn->name);
+    }
   }
   if (check_state())
     return true;
@@ -2061,29 +2685,201 @@ bool translator::trans_module() {
   return check_state();
 }
 
-void translator::collect_operands(const Instruction &I,
-                                  set<const Value *> &operands) {
+/// Returns the allocas and globals whose memory the value of
+/// I may depend on, sorted. A null root stands for memory that
+/// is not known, e.g. read through a pointer argument, which
+/// every write may alias. The roots are cached per function
+/// so operands shared between instructions are walked once.
+ArrayRef<const Value *> translator::collect_operands(const Instruction &I) {
+  auto it = operand_roots.find(&I);
+  if (it != operand_roots.end())
+    return it->second;
+  /// The empty entry breaks cycles through PHINodes.
+  operand_roots[&I];
+  SmallVector<const Value *, 4> roots;
   if (isa<AllocaInst>(I))
-    operands.insert(cast<Value>(&I));
+    roots.push_back(&I);
   else {
+    // A load reads the objects its pointer is based on, which
+    // may be hidden behind constant expressions or arguments.
+    if (const auto *LI = dyn_cast<LoadInst>(&I)) {
+      SmallVector<const Value *, 4> objects;
+      getUnderlyingObjects(LI->getPointerOperand(), objects, nullptr, 0);
+      for (const auto *object : objects)
+        roots.push_back(isa<AllocaInst>(object) || isa<GlobalVariable>(object)
+                            ? object
+                            : nullptr);
+    }
     for (const auto &U : I.operands()) {
       if (isa<GlobalVariable>(U))
-        operands.insert(cast<Value>(&U));
-      else if (isa<Instruction>(U))
-        collect_operands(*cast<Instruction>(U), operands);
+        roots.push_back(U.get());
+      else if (isa<Instruction>(U)) {
+        auto op_roots = collect_operands(*cast<Instruction>(U));
+        roots.append(op_roots.begin(), op_roots.end());
+      }
+    }
+    llvm::sort(roots);
+    roots.erase(unique(roots.begin(), roots.end()), roots.end());
+  }
+  return operand_roots[&I] = std::move(roots);
+}
+
+/// Positions of the memory writes of a function, so that
+/// the writes between two points of a block can be found by
+/// binary search instead of walking the instructions.
+namespace {
+class write_indext {
+  DenseMap<pair<const BasicBlock *, const Value *>,
+                 SmallVector<unsigned, 4>>
+      root_writes; ///< writes to a known alloca or global
+  DenseMap<const BasicBlock *, SmallVector<unsigned, 4>>
+      unknown_writes; ///< writes through unknown pointers and calls
+  DenseMap<const BasicBlock *, SmallVector<unsigned, 4>>
+      all_writes; ///< every write, which may alias an unknown read
+  SmallPtrSet<const Value *, 16> written_roots;
+  bool has_unknown_writes = false;
+  DenseMap<const Value *, bool> escapes;
+
+  /// Returns true if root may be written through a pointer
+  /// whose target is not known.
+  bool may_escape(const Value *root) {
+    if (!isa_and_nonnull<AllocaInst>(root))
+      return true;
+    auto it = escapes.find(root);
+    if (it != escapes.end())
+      return it->second;
+    return escapes[root] = PointerMayBeCaptured(root, false, true);
+  }
+
+  static void add_position(SmallVectorImpl<unsigned> &positions,
+                           unsigned pos) {
+    if (positions.empty() || positions.back() != pos)
+      positions.push_back(pos);
+  }
+
+  void add_unknown_write(const BasicBlock *BB, unsigned pos) {
+    add_position(unknown_writes[BB], pos);
+    add_position(all_writes[BB], pos);
+    has_unknown_writes = true;
+  }
+
+  /// Records a write through ptr against every alloca or
+  /// global it may point to, looking through selects and
+  /// PHINodes. Any other origin is an unknown write.
+  void add_write(const BasicBlock *BB, unsigned pos, const Value *ptr) {
+    SmallVector<const Value *, 4> roots;
+    getUnderlyingObjects(ptr, roots, nullptr, 0);
+    for (const auto *root : roots)
+      if (isa<AllocaInst>(root) || isa<GlobalVariable>(root)) {
+        add_position(root_writes[{BB, root}], pos);
+        add_position(all_writes[BB], pos);
+        written_roots.insert(root);
+      } else
+        add_unknown_write(BB, pos);
+  }
+
+  /// A call may write through each of its pointer arguments,
+  /// even nocapture ones that leave the root unescaped, and
+  /// to any memory that has escaped.
+  void add_call_writes(const BasicBlock *BB, unsigned pos,
+                       const CallBase &CB) {
+    if (!CB.onlyAccessesArgMemory())
+      add_unknown_write(BB, pos);
+    for (const auto &arg : CB.args())
+      if (arg->getType()->isPointerTy() &&
+          !CB.onlyReadsMemory(CB.getArgOperandNo(&arg)))
+        add_write(BB, pos, arg);
+  }
+
+  static bool any_in(const SmallVectorImpl<unsigned> &positions,
+                     unsigned from, unsigned to) {
+    auto it = upper_bound(positions.begin(), positions.end(), from);
+    return it != positions.end() && *it < to;
+  }
+
+public:
+  DenseMap<const Instruction *, unsigned> position;
+
+  explicit write_indext(const Function &F) {
+    for (const auto &BB : F) {
+      unsigned pos = 0;
+      for (const auto &I : BB) {
+        position[&I] = pos;
+        if (const auto *SI = dyn_cast<StoreInst>(&I))
+          add_write(&BB, pos, SI->getPointerOperand());
+        else if (const auto *MI = dyn_cast<MemIntrinsic>(&I))
+          add_write(&BB, pos, MI->getDest());
+        else if (isa<CallInst>(&I) && !isa<DbgInfoIntrinsic>(&I) &&
+                 !I.isLifetimeStartOrEnd() && I.mayWriteToMemory())
+          add_call_writes(&BB, pos, cast<CallInst>(I));
+        pos++;
+      }
     }
   }
-}
+
+  /// Returns true if any root may be written strictly between
+  /// the positions from and to of BB.
+  bool written_between(ArrayRef<const Value *> roots,
+                       const BasicBlock *BB, unsigned from, unsigned to) {
+    for (const auto *root : roots) {
+      if (!root) {
+        auto it = all_writes.find(BB);
+        if (it != all_writes.end() && any_in(it->second, from, to))
+          return true;
+        continue;
+      }
+      auto it = root_writes.find({BB, root});
+      if (it != root_writes.end() && any_in(it->second, from, to))
+        return true;
+    }
+    auto it = unknown_writes.find(BB);
+    if (it != unknown_writes.end() && any_in(it->second, from, to))
+      for (const auto *root : roots)
+        if (may_escape(root))
+          return true;
+    return false;
+  }
+
+  /// Returns true if any root may be written anywhere in
+  /// the function.
+  bool written_anywhere(ArrayRef<const Value *> roots) {
+    for (const auto *root : roots) {
+      if (!root && !all_writes.empty())
+        return true;
+      if (written_roots.count(root) || (has_unknown_writes && may_escape(root)))
+        return true;
+    }
+    return false;
+  }
+};
+} // namespace
 
 /// Does some preliminary analysis. Things like
 ///	mapping alloca instructions to their DbgDeclare
 ///	happen here.
+///
+/// Instructions that don't change the state are translated
+/// lazily where their value is consumed, by a store, call,
+/// branch etc. If the memory an instruction reads can be
+/// written before that point, its value has to be saved
+/// where it is defined instead, which is what
+/// save_state_values records. Blocks are walked backwards so
+/// that for every instruction the farthest point of its block
+/// at which it is consumed is known from its users, and
+/// whether it is consumed in another block at all.
 void translator::analyse_ir() {
   if (check_state())
     return;
-  for (auto &F : *llvm_module)
+  for (auto &F : *llvm_module) {
+    if (F.isDeclaration())
+      continue;
+    write_indext writes(F);
+    /// For each lazily translated instruction, the last
+    /// position in its block where it is consumed and
+    /// whether it is consumed outside its block.
+    DenseMap<const Instruction *, pair<unsigned, bool>> consumed;
     for (auto &BB : F)
-      for (auto &I : BB) {
+      for (auto &I : reverse(BB)) {
         if (isa<DbgDeclareInst>(&I)) {
           auto *CI = cast<CallInst>(&I);
           auto *M = cast<MetadataAsValue>(CI->getOperand(0))->getMetadata();
@@ -2101,39 +2897,52 @@ void translator::analyse_ir() {
             isa<ReturnInst>(&I) || isa<CallInst>(&I) || isa<SwitchInst>(&I) ||
             isa<InsertValueInst>(&I))
           continue;
-        set<const Value *> operands;
-        collect_operands(I, operands);
-        bool already_inserted = false;
+        auto operands = collect_operands(I);
         if (isa<LoadInst>(&I))
           for (const auto a : operands) {
+            if (!a)
+              continue;
             if (a->getType()->isAggregateType() ||
                 (a->getType()->isPointerTy()
                      ? a->getType()->getPointerElementType()->isPointerTy()
                      : false)) {
               save_state_values.insert(&I);
-              already_inserted = true;
               break;
             }
           }
-        if (cast<Value>(&I)->getNumUses() < 2 || already_inserted)
-          continue;
-        set<const StoreInst *> in_btwn_instrs;
-        for (const auto &U : I.uses()) {
-          auto UI = dyn_cast<Instruction>(U.getUser());
-          if (UI->getParent() == I.getParent()) {
-            for (auto it = I.getIterator(); it != UI->getIterator(); it++) {
-              if (isa<StoreInst>(it))
-                in_btwn_instrs.insert(cast<StoreInst>(&*it));
-            }
-          } else {
-            //						TODO: Add support for
-            // inter BasicBlock
+
+        const unsigned pos = writes.position[&I];
+        unsigned last = pos;
+        bool other_block = false;
+        for (const auto *U : I.users()) {
+          const auto *UI = dyn_cast<Instruction>(U);
+          if (!UI)
+            continue;
+          if (UI->getParent() != &BB || isa<PHINode>(UI)) {
+            other_block = true;
+            continue;
+          }
+          auto it = consumed.find(UI);
+          if (it == consumed.end())
+            last = max(last, writes.position[UI]);
+          else {
+            last = max(last, it->second.first);
+            other_block |= it->second.second;
           }
         }
-        for (const auto &SI : in_btwn_instrs)
-          if (operands.find(SI->getOperand(1)) != operands.end())
-            save_state_values.insert(&I);
+
+        /// This holds for values with a single use as well, that
+        /// use still reads the memory at its own position.
+        if (!save_state_values.count(&I) &&
+            (writes.written_between(operands, &BB, pos, last) ||
+             (other_block && writes.written_anywhere(operands))))
+          save_state_values.insert(&I);
+        /// A saved value is consumed where it is defined.
+        if (!save_state_values.count(&I))
+          consumed[&I] = {last, other_block};
       }
+    operand_roots.clear();
+  }
 }
 
 /// This inserts all the function symbols to the
@@ -2184,6 +2993,10 @@ void translator::add_global_symbols() {
       symbol.base_name = G.getName().str();
       symbol.name = symbol.base_name.c_str();
       symbol.is_static_lifetime = true;
+      /// Read-only globals are const qualified, so CBMC can
+      /// propagate their initial values.
+      if (G.isConstant())
+        symbol.type.set(ID_C_constant, true);
     } else {
       error_state = "Global does not have name";
       return;
@@ -2212,6 +3025,7 @@ bool translator::generate_goto() {
   add_function_symbols();
   add_global_symbols();
   analyse_ir();
+  scopes = make_unique<scope_tree>(*llvm_module);
   trans_module();
   if (verbose && !verbose_very) {
     outs() << "  [";
@@ -2238,7 +3052,14 @@ void translator::write_goto(const string &filename) {
   }
 
   ofstream out(filename, ios::binary);
-  if (write_goto_binary(out, symbol_table, goto_functions)) {
+  bool failed;
+  if (compressOutput)
+    failed = write_goto_compressed(out);
+  else if (streamOutput)
+    failed = write_goto_streamed(out);
+  else
+    failed = write_goto_binary(out, symbol_table, goto_functions);
+  if (failed) {
     if (!verbose) {
       outs().changeColor(outs().SAVEDCOLOR, true);
       outs() << "Writing GOTO Binary to: " << filename;
@@ -2258,13 +3079,16 @@ void translator::write_goto(const string &filename) {
   }
 }
 
+translator::translator(unique_ptr<Module> &M) : llvm_module{M} {}
+
 /// Clears the symbol_util and
 /// some other data_structures
 /// to translate multiple irs at once.
 translator::~translator() {
+  if (spool_file)
+    fclose(spool_file);
   symbol_table.clear();
   func_arg_name_map.clear();
-  scope_name_map.clear();
   symbol_util::clear();
   error_state = "";
   intrinsic_support_added.clear();
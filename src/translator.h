@@ -8,6 +8,7 @@
 #ifndef TRANSLATOR_H
 #define TRANSLATOR_H
 
+#include "arena_allocator.h"
 #include "ll2gb.h"
 
 class ll2gb::translator {
@@ -19,44 +20,63 @@ private:
   null_message_handlert msg_handler;
   c_object_factory_parameterst object_factory_params;
 
-  std::map<const llvm::Instruction *, std::string>
-      var_name_map; ///< map from instructions to their symbol names
+  llvm::BumpPtrAllocator
+      function_arena; ///< backs the per-function maps, reset per function
+  arena_map<const llvm::Instruction *, std::string> var_name_map{
+      function_arena}; ///< map from instructions to their symbol names
   std::map<std::string, std::string>
       aux_name_map; /// Map to go back from auxiliary names to original var
                     /// names
-  std::map<const llvm::InsertValueInst *, exprt>
-      ins_value_name_map; ///< map from instructions to their symbol names
+  arena_map<const llvm::InsertValueInst *, exprt> ins_value_name_map{
+      function_arena}; ///< map from instructions to their symbol names
   static std::map<const llvm::Argument *, std::string>
       func_arg_name_map; ///< map from func args to their symbol names
   std::map<const llvm::AllocaInst *, llvm::DbgDeclareInst *>
       alloca_dbg_map; ///< map from Allocas to their DbgDeclare if exists
-  std::map<const llvm::CallInst *, std::string>
-      call_ret_sym_map; ///< map from Call Instructions to their return symbol
-                        ///< names
-  std::map<const llvm::BasicBlock *, goto_programt::targett>
-      block_target_map; ///< map from BB to first goto target for that block
-  std::map<const llvm::BranchInst *,
-           std::pair<goto_programt::targett, goto_programt::targett>>
-      br_instr_target_map; ///< map from BranchInst to their goto targets
-  std::map<const llvm::SwitchInst *, std::vector<goto_programt::targett>>
-      switch_instr_target_map; ///< map from SwitchInst to their goto targets
-  static std::map<llvm::DIScope *, std::string> scope_name_map;
-  std::map<const llvm::Value *, exprt> state_map;
+  arena_map<const llvm::CallInst *, std::string> call_ret_sym_map{
+      function_arena}; ///< map from Call Instructions to their return symbol
+                       ///< names
+  llvm::DenseMap<const llvm::BasicBlock *, unsigned>
+      block_index; ///< dense index of each BB of the current function
+  std::vector<goto_programt::targett>
+      block_targets; ///< first goto target of each BB, by block_index
+  std::vector<std::pair<goto_programt::targett, unsigned>>
+      pending_gotos; ///< gotos waiting for the target of a block index
+  std::vector<goto_programt::targett>
+      return_gotos; ///< gotos waiting for END FUNCTION
+  arena_map<const llvm::Value *, exprt> state_map{function_arena};
   std::set<const llvm::Value *> save_state_values;
+  llvm::DenseMap<const llvm::Instruction *,
+                 llvm::SmallVector<const llvm::Value *, 4>>
+      operand_roots; ///< memoized collect_operands of the current function
+  llvm::DenseMap<const llvm::ConstantDataSequential *, exprt>
+      const_data_map; ///< translated strings and tables, shared by all uses
+  std::FILE *spool_file = nullptr; ///< Holds the functions streamed so far.
+  std::vector<std::pair<irep_idt, std::size_t>>
+      spooled_functions; ///< Names and chunk sizes in the spool file.
 
   bool trans_instruction(const llvm::Instruction &);
   bool trans_block(const llvm::BasicBlock &);
-  void set_branches();
-  void set_switches();
+  void add_block_goto(const exprt &, const llvm::BasicBlock *);
+  void set_targets();
   void set_returns(goto_programt::targett &);
+  void clear_function_maps();
   bool trans_function(llvm::Function &);
   bool trans_module();
   void analyse_ir();
-  void collect_operands(const llvm::Instruction &,
-                        std::set<const llvm::Value *> &);
+  llvm::ArrayRef<const llvm::Value *>
+  collect_operands(const llvm::Instruction &);
+  std::string encode_function(const irep_idt &, goto_programt &);
+  void spool_function(const irep_idt &);
+  bool read_spooled_function(const std::pair<irep_idt, std::size_t> &,
+                             std::string &);
+  bool write_goto_streamed(std::ostream &);
+  bool write_goto_compressed(std::ostream &);
   void add_function_symbols();
   void set_function_symbol_value(goto_functionst::function_mapt &,
                                  symbol_tablet &);
+  void set_function_symbol_value(const irep_idt &, const goto_programt &,
+                                 symbol_tablet &);
   void set_entry_point(goto_functionst &, symbol_tablet &);
   void add_global_symbols();
   void add_initial_symbols();
@@ -71,15 +91,32 @@ private:
   void trans_br(const llvm::BranchInst &);
   void trans_call(const llvm::CallInst &);
   void trans_call_llvm_intrinsic(const llvm::IntrinsicInst &);
+  void assign_intrinsic_result(const llvm::IntrinsicInst &, const exprt &);
+  void trans_overflow_intrinsic(const llvm::IntrinsicInst &);
+  void trans_bit_intrinsic(const llvm::IntrinsicInst &);
+  void trans_arith_intrinsic(const llvm::IntrinsicInst &);
+  bool trans_memcpy_direct(const llvm::MemCpyInst &);
+  bool trans_memset_direct(const llvm::MemSetInst &);
   void trans_insertvalue(const llvm::InsertValueInst &);
   void trans_ret(const llvm::ReturnInst &);
   void trans_store(const llvm::StoreInst &);
+  void trans_unreachable(const llvm::UnreachableInst &);
+  void assume_annotations(const llvm::Instruction &);
   void trans_switch(const llvm::SwitchInst &);
+  struct switch_ranget {
+    const llvm::ConstantInt *low, *high; ///< inclusive bounds
+    const llvm::BasicBlock *dest;
+  };
+  void add_switch_tree(const exprt &, const std::vector<switch_ranget> &,
+                       size_t, size_t, const llvm::BasicBlock *);
 
   exprt get_expr(const llvm::Value &, bool new_state_required = false);
 
   exprt get_expr_phi(const llvm::PHINode &);
   exprt get_expr_extractvalue(const llvm::ExtractValueInst &);
+  exprt get_expr_extractelement(const llvm::ExtractElementInst &);
+  exprt get_expr_insertelement(const llvm::InsertElementInst &);
+  exprt get_expr_shufflevector(const llvm::ShuffleVectorInst &);
   exprt get_expr_gep(const llvm::GetElementPtrInst &);
   exprt get_expr_bitcast(const llvm::BitCastInst &);
   exprt get_expr_fcmp(const llvm::FCmpInst &);
@@ -115,6 +152,7 @@ private:
   exprt get_expr_ptrtoint(const llvm::PtrToIntInst &);
   exprt get_expr_inttoptr(const llvm::IntToPtrInst &);
   exprt get_expr_const(const llvm::Constant &);
+  exprt get_expr_const_data(const llvm::ConstantDataSequential &);
   exprt get_expr_select(const llvm::SelectInst &);
 
   enum class intrinsics {
@@ -190,18 +228,21 @@ private:
   void make_func_call(const llvm::CallInst &);
 
   source_locationt get_location(const llvm::Instruction &);
+  source_locationt get_location(const llvm::Function &);
 
   class symbol_util;
   ///< A sub-class to group all the symbol and type related methods.
   class scope_tree;
   ///< A sub-class to implement the scoping rules.
+  std::unique_ptr<scope_tree> scopes; ///< Built once per module.
 
 public:
   static std::string error_state; ///< If any error is encountered, the errmsg
                                   ///< is stored in this string.
-  translator(std::unique_ptr<llvm::Module> &M) : llvm_module{M} {}
+  translator(std::unique_ptr<llvm::Module> &M);
   bool generate_goto();
   void write_goto(const std::string &);
+  int verify_goto();
 
   /// Returns true if there is any error, signified by non-empty error_state.
   static bool check_state() { return !error_state.empty(); }
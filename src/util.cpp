@@ -16,8 +16,9 @@ using namespace ll2gb;
 
 cl::OptionCategory ll2gb_cat("Options");
 
-cl::opt<string> ll2gb::InputFilename(cl::Positional, cl::desc("<input file>"),
-                                     cl::Required);
+cl::list<string> ll2gb::InputFilenames(cl::Positional,
+                                       cl::desc("<input files>"),
+                                       cl::OneOrMore);
 
 cl::opt<string> ll2gb::outputFilename("o", cl::desc("Specify output filename"),
                                       cl::value_desc("filename"), cl::init(""),
@@ -35,6 +36,63 @@ cl::opt<bool> ll2gb::optEnabled("opt", cl::desc("Enable Optimization of IR"),
 cl::opt<bool> ll2gb::optimizeForced("f", cl::desc("Force Optimizations"),
                                     cl::init(false), cl::cat(ll2gb_cat));
 
+cl::opt<unsigned> ll2gb::passThreads(
+    "j", cl::desc("Number of threads to run the LLVM function passes on"),
+    cl::value_desc("threads"), cl::init(1), cl::cat(ll2gb_cat));
+
+cl::opt<bool> ll2gb::streamOutput(
+    "stream",
+    cl::desc("Release each function once translated and stream it to the "
+             "output file"),
+    cl::init(false), cl::cat(ll2gb_cat));
+
+cl::opt<unsigned> ll2gb::switchTreeThreshold(
+    "switch-tree-threshold",
+    cl::desc("Lower switches with at least this many cases into a decision "
+             "tree, 0 to disable"),
+    cl::value_desc("cases"), cl::init(0), cl::cat(ll2gb_cat));
+
+cl::opt<bool> ll2gb::compressOutput(
+    "compress",
+    cl::desc("Write a zlib compressed GOTO container with a per-function "
+             "index"),
+    cl::init(false), cl::cat(ll2gb_cat));
+
+cl::opt<bool> ll2gb::unpackInput(
+    "unpack",
+    cl::desc("Read a compressed GOTO container and write it out as a GOTO "
+             "binary"),
+    cl::init(false), cl::cat(ll2gb_cat));
+
+cl::list<string> ll2gb::unpackFunctions(
+    "functions",
+    cl::desc("Functions to extract with -unpack, all if not given"),
+    cl::value_desc("name,..."), cl::CommaSeparated, cl::cat(ll2gb_cat));
+
+cl::opt<bool> ll2gb::verifyMode(
+    "verify",
+    cl::desc("Verify the translated program with CBMC instead of writing a "
+             "GOTO binary"),
+    cl::init(false), cl::cat(ll2gb_cat));
+
+cl::opt<string> ll2gb::cbmcOptions(
+    "cbmc-options",
+    cl::desc("Options passed through to CBMC in verify mode, e.g. "
+             "\"--bounds-check --unwind 5\""),
+    cl::value_desc("options"), cl::init(""), cl::cat(ll2gb_cat));
+
+cl::opt<bool> ll2gb::unreachableAssert(
+    "unreachable-assert",
+    cl::desc("Assert that unreachable instructions are never reached instead "
+             "of assuming it"),
+    cl::init(false), cl::cat(ll2gb_cat));
+
+cl::opt<bool> ll2gb::assumeAnnotations(
+    "assume-annotations",
+    cl::desc("Assume the facts stated by !range metadata and nonnull or "
+             "dereferenceable attributes on noundef values"),
+    cl::init(false), cl::cat(ll2gb_cat));
+
 void ll2gb::print_version(raw_ostream &ostream) {
   ostream << "LL2GB Version: 2.0\n\n";
   cl::PrintVersionMessage();
@@ -46,18 +104,27 @@ void ll2gb::parse_input(int argc, char **argv) {
   cl::ParseCommandLineOptions(argc, argv);
 
   /// If output file name is not specified then <inputfilename>.gb is the
-  ///  default name.
+  ///  default name, named after the first input file. Compressed
+  ///  containers get .gbz instead.
   if (outputFilename.empty()) {
-    auto index = InputFilename.find(".ll");
+    const auto &InputFilename = InputFilenames.front();
+    const string extension = compressOutput && !unpackInput ? ".gbz" : ".gb";
+    auto index = InputFilename.find(unpackInput ? ".gbz" : ".ll");
+    if (index == InputFilename.npos && !unpackInput)
+      index = InputFilename.find(".bc");
     if (index != InputFilename.npos)
-      outputFilename = InputFilename.substr(0, index) + ".gb";
+      outputFilename = InputFilename.substr(0, index) + extension;
     else
-      outputFilename = InputFilename + ".gb";
+      outputFilename = InputFilename + extension;
   }
 
   if (verbose_very)
     verbose = true;
 
+  /// Verification needs every function body in memory.
+  if (verifyMode)
+    streamOutput = false;
+
   secret();
 }
 
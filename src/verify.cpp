@@ -0,0 +1,90 @@
+/*
+ * verify.cpp
+ */
+
+#include "ll2gb.h"
+#include "translator.h"
+
+#include <llvm/Support/StringSaver.h>
+
+using namespace std;
+using namespace llvm;
+using namespace ll2gb;
+
+/// Gives access to CBMC's option handling and message
+/// handler so the goto model can be checked in-process.
+class cbmc_verifiert : public cbmc_parse_optionst {
+public:
+  cbmc_verifiert(int argc, const char **argv)
+      : cbmc_parse_optionst(argc, argv),
+        invalid_options(cmdlinet().parse(argc, argv, CBMC_OPTIONS)) {}
+
+  /// Mirrors the checking part of cbmc_parse_optionst::doit,
+  /// starting from an already built goto model.
+  int verify(goto_modelt &goto_model) {
+    if (invalid_options) {
+      log.error() << "invalid CBMC options: " << cbmcOptions << messaget::eom;
+      return CPROVER_EXIT_USAGE_ERROR;
+    }
+    messaget::eval_verbosity(cmdline.get_value("verbosity"),
+                             messaget::M_STATISTICS, ui_message_handler);
+
+    // As when cbmc reads a GOTO binary, the options come first
+    // and the architecture of the translated program then wins.
+    if (config.set(cmdline)) {
+      log.error() << "invalid CBMC options: " << cbmcOptions << messaget::eom;
+      return CPROVER_EXIT_USAGE_ERROR;
+    }
+    config.set_from_symbol_table(goto_model.symbol_table);
+
+    optionst options;
+    get_command_line_options(options);
+
+    goto_convert(goto_model.symbol_table, goto_model.goto_functions,
+                 ui_message_handler);
+    if (process_goto_program(goto_model, options, log))
+      return CPROVER_EXIT_INTERNAL_ERROR;
+
+    unique_ptr<goto_verifiert> verifier;
+    if (options.get_bool_option("stop-on-fail"))
+      verifier =
+          make_unique<stop_on_fail_verifiert<multi_path_symex_checkert>>(
+              options, ui_message_handler, goto_model);
+    else
+      verifier = make_unique<
+          all_properties_verifier_with_trace_storaget<multi_path_symex_checkert>>(
+          options, ui_message_handler, goto_model);
+
+    const resultt result = (*verifier)();
+    verifier->report();
+    return result_to_exit_code(result);
+  }
+
+private:
+  /// The base class keeps its own parse result to itself, so
+  /// the options are parsed once more to check them.
+  const bool invalid_options;
+};
+
+/// Hands the translated program to CBMC without writing
+/// it to disk. Returns CBMC's exit code.
+int translator::verify_goto() {
+  BumpPtrAllocator A;
+  StringSaver saver(A);
+  SmallVector<const char *, 16> argv;
+  argv.push_back("cbmc");
+  cl::TokenizeGNUCommandLine(cbmcOptions, saver, argv);
+
+  if (verbose) {
+    outs().changeColor(outs().SAVEDCOLOR, true);
+    outs() << "Verifying GOTO Program with CBMC\n";
+    outs().resetColor();
+  }
+
+  goto_modelt goto_model;
+  goto_model.symbol_table.swap(symbol_table);
+  goto_model.goto_functions.swap(goto_functions);
+
+  cbmc_verifiert cbmc(argv.size(), argv.data());
+  return cbmc.verify(goto_model);
+}